@@ -0,0 +1,255 @@
+package com.aidan.cmel;
+
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.List;
+
+import static com.aidan.cmel.TokenType.*;
+
+// An element-wise loop over float64 arrays, recognised from the shape
+//
+//     while (i < n) { c[i] = <expression>; i = i + 1; }
+//
+// where the expression only adds, subtracts, multiplies and negates numbers,
+// loop-invariant variables, i itself and elements a[i] of other arrays. Every
+// iteration touches only its own element, so the loop is run a block of
+// elements at a time with one tight double[] loop per operation, which the JIT
+// turns into SIMD code.
+final class ArrayKernel {
+    private static final int BLOCK = 256;
+
+    private final Expression.Variable counter;
+    private final Expression limit;
+    private final Expression.Variable increment;
+    private final Operation root;
+    private final List<Expression.Variable> arrays;
+    private final List<Expression.Variable> scalars;
+    private final int temporaries;
+
+    private ArrayKernel(Expression.Variable counter, Expression limit, Expression.Variable increment, Compiler compiler) {
+        this.counter = counter;
+        this.limit = limit;
+        this.increment = increment;
+        this.root = compiler.root;
+        this.arrays = compiler.arrays;
+        this.scalars = compiler.scalars;
+        this.temporaries = compiler.temporaries;
+    }
+
+    // Answers null when the loop isn't one a kernel can run.
+    static ArrayKernel match(Statement.While loop) {
+        Expression.Variable counter;
+        Expression limit;
+        if (loop.condition instanceof Expression.LessThanConstant condition) {
+            counter = condition.variable;
+            limit = new Expression.Literal(condition.constant);
+        } else if (loop.condition instanceof Expression.Binary condition && condition.operator.getType() == LESS
+                && condition.left instanceof Expression.Variable variable) {
+            counter = variable;
+            limit = condition.right;
+        } else {
+            return null;
+        }
+        String name = counter.name.getLexeme();
+        if (!isInvariant(limit, name)) return null;
+
+        if (!(loop.body instanceof Statement.Block block)) return null;
+        List<Statement> body = block.statements;
+        if (body.size() != 2) return null;
+
+        Expression.Variable increment = asIncrement(body.get(1), name);
+        if (increment == null) return null;
+
+        Statement statement = body.get(0);
+        if (statement instanceof Statement.Block inner && inner.statements.size() == 1)
+            statement = inner.statements.get(0);
+        if (!(statement instanceof Statement.ExpressionStatement expression)
+                || !(expression.expression instanceof Expression.IndexSet store)
+                || !(store.object instanceof Expression.Variable target)
+                || !isCounter(store.index, name)
+                || target.name.getLexeme().equals(name))
+            return null;
+
+        Compiler compiler = new Compiler(name);
+        compiler.root = compiler.compile(store.value);
+        if (compiler.root == null) return null;
+        compiler.arrays.add(0, target);
+
+        return new ArrayKernel(counter, limit, increment, compiler);
+    }
+
+    private static boolean isCounter(Expression expression, String name) {
+        return expression instanceof Expression.Variable variable && variable.name.getLexeme().equals(name);
+    }
+
+    private static boolean isInvariant(Expression expression, String name) {
+        if (expression instanceof Expression.Literal literal) return literal.value instanceof Double;
+        return expression instanceof Expression.Variable && !isCounter(expression, name);
+    }
+
+    // The parser fuses i = i + 1 into an IncrementBy; answers its variable.
+    private static Expression.Variable asIncrement(Statement statement, String name) {
+        if (!(statement instanceof Statement.ExpressionStatement expression)
+                || !(expression.expression instanceof Expression.IncrementBy increment)
+                || !isCounter(increment.variable, name)
+                || increment.operator.getType() != PLUS
+                || increment.amount != 1)
+            return null;
+        return increment.variable;
+    }
+
+    // Runs the whole loop, or answers false without having done anything when
+    // the values it finds aren't what the kernel needs, so the interpreter can
+    // run it the ordinary way and report any error where it belongs.
+    boolean run(Interpreter interpreter) {
+        Object first;
+        Object end;
+        double[][] data = new double[arrays.size()][];
+        double[] values = new double[scalars.size()];
+        try {
+            first = interpreter.visitVariableExpression(counter);
+            end = interpreter.evaluate(limit);
+            if (!(first instanceof Double start) || !(end instanceof Double) || start != Math.floor(start) || start < 0)
+                return false;
+
+            for (int i = 0; i < data.length; i++) {
+                if (!(interpreter.visitVariableExpression(arrays.get(i)) instanceof CmelFloat64Array array)) return false;
+                data[i] = array.elements;
+            }
+            for (int i = 0; i < values.length; i++) {
+                if (!(interpreter.visitVariableExpression(scalars.get(i)) instanceof Double value)) return false;
+                values[i] = value;
+            }
+        } catch (RuntimeError error) {
+            return false;
+        }
+
+        double start = (double) first;
+        double count = Math.ceil((double) end - start);
+        if (!(count > 0)) return true;
+        for (double[] array : data)
+            if (start + count > array.length) return false;
+
+        Frame frame = new Frame(data, values, temporaries);
+        double[] result = new double[BLOCK];
+        int from = (int) start;
+        int to = (int) (start + count);
+        for (int offset = from; offset < to; offset += BLOCK) {
+            int length = Math.min(BLOCK, to - offset);
+            root.apply(frame, offset, length, result);
+            System.arraycopy(result, 0, data[0], offset, length);
+        }
+
+        interpreter.assign(increment, increment.name, (double) to);
+        return true;
+    }
+
+    private static final class Frame {
+        final double[][] arrays;
+        final double[] scalars;
+        final double[][] temporaries;
+
+        Frame(double[][] arrays, double[] scalars, int temporaries) {
+            this.arrays = arrays;
+            this.scalars = scalars;
+            this.temporaries = new double[temporaries][BLOCK];
+        }
+    }
+
+    // Fills out[0, length) with the operation's value at elements
+    // [offset, offset + length).
+    private interface Operation {
+        void apply(Frame frame, int offset, int length, double[] out);
+    }
+
+    private static final class Compiler {
+        final String counter;
+        final List<Expression.Variable> arrays = new ArrayList<>();
+        final List<Expression.Variable> scalars = new ArrayList<>();
+        int temporaries = 0;
+        Operation root;
+
+        Compiler(String counter) {
+            this.counter = counter;
+        }
+
+        // Answers null for anything outside the kernel's language.
+        Operation compile(Expression expression) {
+            if (expression instanceof Expression.Grouping grouping)
+                return compile(grouping.expression);
+
+            if (expression instanceof Expression.Literal literal) {
+                if (!(literal.value instanceof Double value)) return null;
+                return (frame, offset, length, out) -> Arrays.fill(out, 0, length, value);
+            }
+
+            if (expression instanceof Expression.Variable variable) {
+                if (isCounter(variable, counter)) {
+                    return (frame, offset, length, out) -> {
+                        for (int i = 0; i < length; i++) out[i] = offset + i;
+                    };
+                }
+                int slot = scalars.size();
+                scalars.add(variable);
+                return (frame, offset, length, out) -> Arrays.fill(out, 0, length, frame.scalars[slot]);
+            }
+
+            if (expression instanceof Expression.Index index) {
+                if (!(index.object instanceof Expression.Variable array) || !isCounter(index.index, counter)
+                        || isCounter(array, counter))
+                    return null;
+                // Slot 0 is kept for the array being written.
+                int slot = arrays.size() + 1;
+                arrays.add(array);
+                return (frame, offset, length, out) -> System.arraycopy(frame.arrays[slot], offset, out, 0, length);
+            }
+
+            if (expression instanceof Expression.Unary unary) {
+                if (unary.operator.getType() != MINUS) return null;
+                Operation right = compile(unary.right);
+                if (right == null) return null;
+                return (frame, offset, length, out) -> {
+                    right.apply(frame, offset, length, out);
+                    for (int i = 0; i < length; i++) out[i] = -out[i];
+                };
+            }
+
+            if (expression instanceof Expression.Binary binary)
+                return compileBinary(binary);
+
+            return null;
+        }
+
+        // Division is left to the interpreter, which reports division by zero.
+        private Operation compileBinary(Expression.Binary binary) {
+            TokenType operator = binary.operator.getType();
+            if (operator != PLUS && operator != MINUS && operator != STAR) return null;
+
+            Operation left = compile(binary.left);
+            Operation right = compile(binary.right);
+            if (left == null || right == null) return null;
+            int temporary = temporaries++;
+
+            return switch (operator) {
+                case PLUS -> (frame, offset, length, out) -> {
+                    double[] other = frame.temporaries[temporary];
+                    left.apply(frame, offset, length, out);
+                    right.apply(frame, offset, length, other);
+                    for (int i = 0; i < length; i++) out[i] += other[i];
+                };
+                case MINUS -> (frame, offset, length, out) -> {
+                    double[] other = frame.temporaries[temporary];
+                    left.apply(frame, offset, length, out);
+                    right.apply(frame, offset, length, other);
+                    for (int i = 0; i < length; i++) out[i] -= other[i];
+                };
+                default -> (frame, offset, length, out) -> {
+                    double[] other = frame.temporaries[temporary];
+                    left.apply(frame, offset, length, out);
+                    right.apply(frame, offset, length, other);
+                    for (int i = 0; i < length; i++) out[i] *= other[i];
+                };
+            };
+        }
+    }
+}
@@ -72,6 +72,46 @@ public class AstPrinter implements Expression.Visitor<String> {
         return parenthesize("anonFunc", expression);
     }
 
+    @Override
+    public String visitComptimeExpression(Expression.Comptime expression) {
+        return parenthesize("comptime", expression.expression);
+    }
+
+    @Override
+    public String visitIndexExpression(Expression.Index expression) {
+        return parenthesize("index", expression.object, expression.index);
+    }
+
+    @Override
+    public String visitIndexSetExpression(Expression.IndexSet expression) {
+        return parenthesize("index-set", expression.object, expression.index, expression.value);
+    }
+
+    @Override
+    public String visitInterpolationExpression(Expression.Interpolation expression) {
+        return parenthesize("interpolate", expression.values.toArray(new Expression[0]));
+    }
+
+    @Override
+    public String visitLessThanConstantExpression(Expression.LessThanConstant expression) {
+        return parenthesize("< " + Interpreter.stringify(expression.constant), expression.variable);
+    }
+
+    @Override
+    public String visitIncrementByExpression(Expression.IncrementBy expression) {
+        return parenthesize("increment " + expression.operator.getLexeme() + " " + Interpreter.stringify(expression.amount), expression.variable);
+    }
+
+    @Override
+    public String visitGetThisFieldExpression(Expression.GetThisField expression) {
+        return parenthesize("this." + expression.name.getLexeme());
+    }
+
+    @Override
+    public String visitCallVariableExpression(Expression.CallVariable expression) {
+        return parenthesize("call " + expression.callee.name.getLexeme(), expression.arguments.toArray(new Expression[0]));
+    }
+
     private String parenthesize(String name, Expression... expressions) {
         StringBuilder builder = new StringBuilder();
         builder.append('(').append(name);
@@ -0,0 +1,45 @@
+package com.aidan.cmel;
+
+// The kind of callee last seen at a call expression. Functions are recognised
+// by their declaration rather than kept themselves: a bound method or a
+// closure is made afresh for each call and holds its receiver or environment,
+// which the site would otherwise keep alive. A site that keeps seeing new
+// callees stops recording them after MAX_MISSES.
+final class CallSite {
+    static final int MAX_MISSES = 8;
+
+    enum Kind {
+        FUNCTION, ANONYMOUS_FUNCTION, CLASS, GENERIC
+    }
+
+    private final Object key;
+    final Kind kind;
+    final int misses;
+
+    CallSite(CmelCallable callee, int misses) {
+        this.key = keyOf(callee);
+        this.kind = kindOf(callee);
+        this.misses = misses;
+    }
+
+    boolean matches(Object callee) {
+        return key == keyOf(callee);
+    }
+
+    boolean isMegamorphic() {
+        return misses >= MAX_MISSES;
+    }
+
+    private static Object keyOf(Object callee) {
+        if (callee instanceof CmelFunction function) return function.getDeclaration();
+        if (callee instanceof CmelAnonFunction function) return function.getDeclaration();
+        return callee;
+    }
+
+    private static Kind kindOf(CmelCallable callee) {
+        if (callee instanceof CmelFunction) return Kind.FUNCTION;
+        if (callee instanceof CmelAnonFunction) return Kind.ANONYMOUS_FUNCTION;
+        if (callee instanceof CmelClass) return Kind.CLASS;
+        return Kind.GENERIC;
+    }
+}
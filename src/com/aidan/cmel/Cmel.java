@@ -6,6 +6,7 @@ import java.io.InputStreamReader;
 import java.nio.charset.Charset;
 import java.nio.file.Files;
 import java.nio.file.Paths;
+import java.util.ArrayList;
 import java.util.List;
 
 import static com.aidan.cmel.TokenType.EOF;
@@ -16,10 +17,23 @@ public class Cmel {
     private static boolean hadRuntimeError;
 
     private static Interpreter interpreter = new Interpreter();
+    private static String scriptPath = null;
 
     public static void main(String[] args) throws IOException, InterruptedException {
-        if (args.length > 1) {
-            System.out.println("Usage: cmel [script]");
+        if (args.length == 1 && args[0].equals("--lsp")) {
+            System.exit(LanguageServer.serve(System.in, System.out));
+        } else if (args.length == 2 && args[0].equals("--worker")) {
+            runWorker(args[1]);
+        } else if (args.length == 3 && args[0].equals("--compile")) {
+            compile(args[1], args[2]);
+        } else if (args.length == 2 && args[0].equals("--superinstructions")) {
+            Superinstructions.counting = true;
+            Runtime.getRuntime().addShutdownHook(new Thread(() -> Superinstructions.report(System.err)));
+            runFile(args[1]);
+        } else if (args.length > 1) {
+            System.out.println("Usage: cmel [--superinstructions] [script | image]");
+            System.out.println("       cmel --compile script image");
+            System.out.println("       cmel --lsp");
             System.exit(64);
         } else if (args.length == 1) {
             runFile(args[0]);
@@ -29,13 +43,63 @@ public class Cmel {
     }
 
     private static void runFile(String path) throws IOException {
-        byte[] bytes = Files.readAllBytes(Paths.get(path));
-        run(new String(bytes, Charset.defaultCharset()));
+        scriptPath = Paths.get(path).toAbsolutePath().toString();
+        if (CompiledImage.isImage(Paths.get(path))) {
+            interpreter.interpret(CompiledImage.load(Paths.get(path), interpreter));
+        } else {
+            byte[] bytes = Files.readAllBytes(Paths.get(path));
+            run(new String(bytes, Charset.defaultCharset()));
+        }
 
         if (hadError) System.exit(65);
         if (hadRuntimeError) System.exit(70);
     }
 
+    // Parses and resolves the script, running its comptime expressions, and
+    // writes the result as a CompiledImage without running it.
+    private static void compile(String path, String imagePath) throws IOException {
+        byte[] bytes = Files.readAllBytes(Paths.get(path));
+        Parser parser = new Parser(new Scanner(new String(bytes, Charset.defaultCharset())), new Resolver(interpreter));
+        List<Statement> statements = parser.parse();
+        if (hadError) System.exit(65);
+
+        try {
+            ImageWriter.write(interpreter, statements, Paths.get(imagePath));
+        } catch (RuntimeError error) {
+            error(error.getToken(), error.getMessage());
+            System.exit(65);
+        }
+    }
+
+    // Loads only the script's top-level functions and classes, then serves a
+    // WorkerPool over standard input and output.
+    private static void runWorker(String path) throws IOException {
+        scriptPath = path;
+        List<Statement> statements;
+        if (CompiledImage.isImage(Paths.get(path))) {
+            statements = CompiledImage.load(Paths.get(path), interpreter);
+        } else {
+            byte[] bytes = Files.readAllBytes(Paths.get(path));
+            Parser parser = new Parser(new Scanner(new String(bytes, Charset.defaultCharset())), new Resolver(interpreter));
+            statements = parser.parse();
+            if (hadError) System.exit(65);
+        }
+
+        List<Statement> declarations = new ArrayList<>();
+        for (Statement statement : statements) {
+            if (statement instanceof Statement.Function || statement instanceof Statement.Class)
+                declarations.add(statement);
+        }
+        interpreter.interpret(declarations);
+        if (hadRuntimeError) System.exit(70);
+
+        WorkerProcess.serve(interpreter);
+    }
+
+    static String scriptPath() {
+        return scriptPath;
+    }
+
     private static void runPrompt() throws IOException, InterruptedException {
         InputStreamReader input = new InputStreamReader(System.in);
         BufferedReader reader = new BufferedReader(input);
@@ -56,26 +120,49 @@ public class Cmel {
     }
 
     private static void run(String source) {
-        Scanner scanner = new Scanner(source);
-        List<Token> tokens = scanner.scanTokens();
-        Parser parser = new Parser(tokens);
+        // Large scripts are scanned up front on several threads rather than
+        // as the parser goes.
+        Parser parser;
+        if (ParallelScanner.worthSplitting(source)) {
+            List<Token> tokens = ParallelScanner.scanTokens(source);
+            parser = new Parser(tokens, hadError, new Resolver(interpreter));
+        } else {
+            parser = new Parser(new Scanner(source), new Resolver(interpreter));
+        }
         List<Statement> statements = parser.parse();
 
         if (hadError) return;
 
-        Resolver resolver = new Resolver(interpreter);
-        resolver.resolve(statements);
+        interpreter.interpret(statements);
+    }
 
-        if (hadError) return;
+    // Receives front end errors in place of standard error, for a language
+    // server checking a document.
+    interface ErrorListener {
+        void error(int line, Token token, String message);
+    }
 
-        interpreter.interpret(statements);
+    private static final ThreadLocal<ErrorListener> errorListener = new ThreadLocal<>();
+
+    // Sends this thread's front end errors to listener, or back to standard
+    // error when it is null.
+    static void listenForErrors(ErrorListener listener) {
+        errorListener.set(listener);
     }
 
     public static void error(int line, String message) {
-        report(line, "", message);
+        ErrorListener listener = errorListener.get();
+        if (listener != null) listener.error(line, null, message);
+        else report(line, "", message);
     }
 
     public static void error(Token token, String message) {
+        ErrorListener listener = errorListener.get();
+        if (listener != null) {
+            listener.error(token.getLine(), token, message);
+            return;
+        }
+
         if (token.getType() == EOF)
             report(token.getLine(), " at end", message);
         else
@@ -2,7 +2,7 @@ package com.aidan.cmel;
 
 import java.util.List;
 
-public class CmelAnonFunction implements CmelCallable {
+public final class CmelAnonFunction implements CmelCallable {
     private final Expression.AnonFunction declaration;
     private final Environment closure;
 
@@ -26,6 +26,10 @@ public class CmelAnonFunction implements CmelCallable {
         return null;
     }
 
+    Expression.AnonFunction getDeclaration() {
+        return declaration;
+    }
+
     @Override
     public int arity() {
         return declaration.parameters.size();
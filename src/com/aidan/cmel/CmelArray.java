@@ -0,0 +1,39 @@
+package com.aidan.cmel;
+
+public final class CmelArray implements CmelIndexable {
+    private final Object[] elements;
+
+    public CmelArray(int length) {
+        this.elements = new Object[length];
+    }
+
+    @Override
+    public Object get(Object index) {
+        return elements[CmelIndexable.toIndex(index, elements.length)];
+    }
+
+    @Override
+    public void set(Object index, Object value) {
+        elements[CmelIndexable.toIndex(index, elements.length)] = value;
+    }
+
+    @Override
+    public int length() {
+        return elements.length;
+    }
+
+    @Override
+    public boolean hasIndependentSlots() {
+        return true;
+    }
+
+    @Override
+    public String toString() {
+        StringBuilder builder = new StringBuilder("[");
+        for (int i = 0; i < elements.length; i++) {
+            if (i > 0) builder.append(", ");
+            builder.append(Interpreter.stringify(elements[i]));
+        }
+        return builder.append(']').toString();
+    }
+}
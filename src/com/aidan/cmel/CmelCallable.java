@@ -5,4 +5,16 @@ import java.util.List;
 public interface CmelCallable {
     Object call(Interpreter interpreter, List<Object> arguments);
     int arity();
+
+    // The most observable thing a call can do. Callables that perform I/O
+    // can't be run by comptime expressions or inside a parallel for.
+    default Effect effect() {
+        return Effect.PURE;
+    }
+
+    // The effect of a call with these arguments, for callables that only
+    // write to some of the things they are given.
+    default Effect effect(List<Object> arguments) {
+        return effect();
+    }
 }
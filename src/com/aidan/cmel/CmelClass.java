@@ -3,13 +3,15 @@ package com.aidan.cmel;
 import java.util.List;
 import java.util.Map;
 
-public class CmelClass implements CmelCallable {
+public final class CmelClass implements CmelCallable {
     final String name;
     final Map<String, CmelFunction> methods;
+    private final CmelFunction initializer;
 
     public CmelClass(String name, Map<String, CmelFunction> methods) {
         this.name = name;
         this.methods = methods;
+        this.initializer = methods.get("init");
     }
 
     public CmelFunction findMethod(String name) {
@@ -22,8 +24,7 @@ public class CmelClass implements CmelCallable {
 
     @Override
     public Object call(Interpreter interpreter, List<Object> arguments) {
-        CmelInstance instance = new CmelInstance(this);
-        CmelFunction initializer = findMethod("init");
+        CmelInstance instance = interpreter.allocated(new CmelInstance(this));
         if (initializer != null) {
             initializer.bind(instance).call(interpreter, arguments);
         }
@@ -33,7 +34,6 @@ public class CmelClass implements CmelCallable {
 
     @Override
     public int arity() {
-        CmelFunction initializer = findMethod("init");
         if (initializer == null) return 0;
         return initializer.arity();
     }
@@ -0,0 +1,42 @@
+package com.aidan.cmel;
+
+import java.util.Arrays;
+
+// Numbers rounded to single precision, at half the memory of a float64Array.
+public final class CmelFloat32Array extends CmelTypedArray {
+    private final float[] elements;
+
+    public CmelFloat32Array(int length) {
+        this.elements = new float[length];
+    }
+
+    @Override
+    String kind() {
+        return "Float32";
+    }
+
+    @Override
+    Object storage() {
+        return elements;
+    }
+
+    @Override
+    public double getNumber(int index) {
+        return elements[index];
+    }
+
+    @Override
+    public void setNumber(int index, double value) {
+        elements[index] = (float) value;
+    }
+
+    @Override
+    public int length() {
+        return elements.length;
+    }
+
+    @Override
+    public void fill(double value) {
+        Arrays.fill(elements, (float) value);
+    }
+}
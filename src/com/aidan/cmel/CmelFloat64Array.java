@@ -0,0 +1,49 @@
+package com.aidan.cmel;
+
+import java.util.Arrays;
+import java.util.function.DoubleSupplier;
+
+// A fixed-length array of numbers stored unboxed, so that numeric loops over it
+// can be run directly over the backing double[].
+public final class CmelFloat64Array extends CmelTypedArray {
+    final double[] elements;
+
+    public CmelFloat64Array(int length) {
+        this.elements = new double[length];
+    }
+
+    @Override
+    String kind() {
+        return "Float64";
+    }
+
+    @Override
+    Object storage() {
+        return elements;
+    }
+
+    @Override
+    public double getNumber(int index) {
+        return elements[index];
+    }
+
+    @Override
+    public void setNumber(int index, double value) {
+        elements[index] = value;
+    }
+
+    @Override
+    public int length() {
+        return elements.length;
+    }
+
+    @Override
+    public void fill(double value) {
+        Arrays.fill(elements, value);
+    }
+
+    public void fill(DoubleSupplier source) {
+        for (int i = 0; i < elements.length; i++)
+            elements[i] = source.getAsDouble();
+    }
+}
@@ -2,7 +2,7 @@ package com.aidan.cmel;
 
 import java.util.List;
 
-public class CmelFunction implements CmelCallable {
+public final class CmelFunction implements CmelCallable {
     private final Statement.Function declaration;
     private final Environment closure;
     private final boolean isInitializer;
@@ -31,6 +31,10 @@ public class CmelFunction implements CmelCallable {
         return null;
     }
 
+    Statement.Function getDeclaration() {
+        return declaration;
+    }
+
     public CmelFunction bind(CmelInstance instance) {
         Environment environment = new Environment(closure);
         environment.define("this", instance);
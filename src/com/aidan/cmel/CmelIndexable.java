@@ -0,0 +1,27 @@
+package com.aidan.cmel;
+
+public interface CmelIndexable {
+    Object get(Object index);
+    void set(Object index, Object value);
+    int length();
+
+    // True when writes to different indices never interfere, so a parallel for
+    // may have each iteration write its own slot.
+    default boolean hasIndependentSlots() {
+        return false;
+    }
+
+    static int toIndex(Object index, int length) {
+        if (!(index instanceof Double number))
+            throw new RuntimeError("Index must be a whole number.");
+        return toIndex((double) number, length);
+    }
+
+    static int toIndex(double index, int length) {
+        if (index != Math.floor(index))
+            throw new RuntimeError("Index must be a whole number.");
+        if (index < 0 || index >= length)
+            throw new RuntimeError("Index " + Interpreter.stringify(index) + " is out of bounds for length " + length + ".");
+        return (int) index;
+    }
+}
@@ -1,20 +1,24 @@
 package com.aidan.cmel;
 
-import java.util.HashMap;
 import java.util.Map;
+import java.util.concurrent.ConcurrentHashMap;
 
 public class CmelInstance {
     private CmelClass klass;
 
-    private final Map<String, Object> fields = new HashMap<>();
+    private final Map<String, TVar> fields = new ConcurrentHashMap<>();
 
     public CmelInstance(CmelClass klass) {
         this.klass = klass;
     }
 
-    public Object get(Token name) {
-        if (fields.containsKey(name.getLexeme()))
-            return fields.get(name.getLexeme());
+    // A null transaction reads and writes the fields directly.
+    public Object get(Token name, Transaction transaction) {
+        TVar field = fields.get(name.getLexeme());
+        if (field != null) {
+            Object value = transaction == null ? field.get() : transaction.read(field);
+            if (value != TVar.ABSENT) return value;
+        }
 
         CmelFunction method = klass.findMethod(name.getLexeme());
         if (method != null) return method.bind(this);
@@ -22,8 +26,18 @@ public class CmelInstance {
         throw new RuntimeError(name, "Undefined property '" + name.getLexeme() + "'.");
     }
 
-    public void set(Token name, Object value) {
-        fields.put(name.getLexeme(), value);
+    public void set(Token name, Object value, Transaction transaction) {
+        if (transaction != null) {
+            transaction.write(fields.computeIfAbsent(name.getLexeme(), key -> new TVar(TVar.ABSENT)), value);
+            return;
+        }
+
+        TVar field = fields.get(name.getLexeme());
+        if (field == null) {
+            field = fields.putIfAbsent(name.getLexeme(), new TVar(value));
+            if (field == null) return;
+        }
+        field.set(value);
     }
 
     public String toString() {
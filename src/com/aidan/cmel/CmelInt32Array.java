@@ -0,0 +1,49 @@
+package com.aidan.cmel;
+
+import java.util.Arrays;
+
+// Whole numbers that fit in 32 bits. Anything else is an error rather than
+// being wrapped or truncated.
+public final class CmelInt32Array extends CmelTypedArray {
+    private final int[] elements;
+
+    public CmelInt32Array(int length) {
+        this.elements = new int[length];
+    }
+
+    @Override
+    String kind() {
+        return "Int32";
+    }
+
+    @Override
+    Object storage() {
+        return elements;
+    }
+
+    @Override
+    public double getNumber(int index) {
+        return elements[index];
+    }
+
+    @Override
+    public void setNumber(int index, double value) {
+        elements[index] = check(value);
+    }
+
+    @Override
+    public int length() {
+        return elements.length;
+    }
+
+    @Override
+    public void fill(double value) {
+        Arrays.fill(elements, check(value));
+    }
+
+    private static int check(double value) {
+        if (value != (int) value)
+            throw new RuntimeError("Int32 arrays can only hold whole numbers from -2147483648 to 2147483647.");
+        return (int) value;
+    }
+}
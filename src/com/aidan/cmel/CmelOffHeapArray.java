@@ -0,0 +1,93 @@
+package com.aidan.cmel;
+
+import java.lang.foreign.Arena;
+import java.lang.foreign.MemorySegment;
+import java.lang.foreign.ValueLayout;
+import java.util.function.DoubleSupplier;
+
+// A fixed-length array of numbers held outside the Java heap, either freshly
+// allocated or mapped from a file, so that very large datasets cost the GC
+// nothing. The memory lives until the array is freed; using it afterwards is
+// an error rather than a crash.
+public final class CmelOffHeapArray implements CmelIndexable {
+    private final MemorySegment segment;
+    private final Arena arena;
+    private final long length;
+
+    public CmelOffHeapArray(MemorySegment segment, Arena arena) {
+        this.segment = segment;
+        this.arena = arena;
+        this.length = segment.byteSize() / ValueLayout.JAVA_DOUBLE.byteSize();
+    }
+
+    public static CmelOffHeapArray allocate(long length) {
+        Arena arena = Arena.ofShared();
+        MemorySegment segment = arena.allocate(ValueLayout.JAVA_DOUBLE, length);
+        return new CmelOffHeapArray(segment, arena);
+    }
+
+    // The elements, for natives that want to work on them in place.
+    public MemorySegment segment() {
+        return segment;
+    }
+
+    public void free() {
+        try {
+            arena.close();
+        } catch (IllegalStateException e) {
+            throw new RuntimeError("Off-heap array has already been freed.");
+        }
+    }
+
+    @Override
+    public Object get(Object index) {
+        int i = CmelIndexable.toIndex(index, length());
+        try {
+            return segment.getAtIndex(ValueLayout.JAVA_DOUBLE, i);
+        } catch (IllegalStateException e) {
+            throw new RuntimeError("Off-heap array used after it was freed.");
+        }
+    }
+
+    @Override
+    public void set(Object index, Object value) {
+        int i = CmelIndexable.toIndex(index, length());
+        if (!(value instanceof Double number))
+            throw new RuntimeError("Off-heap arrays can only hold numbers.");
+        try {
+            segment.setAtIndex(ValueLayout.JAVA_DOUBLE, i, number);
+        } catch (IllegalStateException e) {
+            throw new RuntimeError("Off-heap array used after it was freed.");
+        } catch (UnsupportedOperationException e) {
+            throw new RuntimeError("Off-heap array is read-only.");
+        }
+    }
+
+    // Indices are Cmel numbers turned into ints, so only the first
+    // Integer.MAX_VALUE elements can be reached by indexing.
+    @Override
+    public int length() {
+        return (int) Math.min(length, Integer.MAX_VALUE);
+    }
+
+    public void fill(DoubleSupplier source) {
+        try {
+            for (long i = 0; i < length; i++)
+                segment.setAtIndex(ValueLayout.JAVA_DOUBLE, i, source.getAsDouble());
+        } catch (IllegalStateException e) {
+            throw new RuntimeError("Off-heap array used after it was freed.");
+        } catch (UnsupportedOperationException e) {
+            throw new RuntimeError("Off-heap array is read-only.");
+        }
+    }
+
+    @Override
+    public boolean hasIndependentSlots() {
+        return true;
+    }
+
+    @Override
+    public String toString() {
+        return "<off-heap array of " + length + ">";
+    }
+}
@@ -0,0 +1,63 @@
+package com.aidan.cmel;
+
+// A fixed-length array of numbers kept in a primitive Java array of one
+// element type. The interpreter reads and writes elements through getNumber
+// and setNumber where it can, so numeric code never boxes them.
+public abstract class CmelTypedArray implements CmelIndexable {
+    // The element type's name, as in "Int32 arrays can only hold numbers.".
+    abstract String kind();
+
+    // The primitive array, for copying between arrays of the same type.
+    abstract Object storage();
+
+    public abstract double getNumber(int index);
+
+    // Fails when value isn't one the element type can hold.
+    public abstract void setNumber(int index, double value);
+
+    @Override
+    public Object get(Object index) {
+        return getNumber(CmelIndexable.toIndex(index, length()));
+    }
+
+    @Override
+    public void set(Object index, Object value) {
+        set(CmelIndexable.toIndex(index, length()), value);
+    }
+
+    void set(int index, Object value) {
+        if (!(value instanceof Double number))
+            throw new RuntimeError(kind() + " arrays can only hold numbers.");
+        setNumber(index, number);
+    }
+
+    public void fill(double value) {
+        for (int i = 0; i < length(); i++) setNumber(i, value);
+    }
+
+    // Copies count elements from start into target from targetStart. Arrays
+    // of the same type are copied as memory, overlapping or not.
+    public void copy(int start, CmelTypedArray target, int targetStart, int count) {
+        if (target.getClass() == getClass()) {
+            System.arraycopy(storage(), start, target.storage(), targetStart, count);
+            return;
+        }
+        for (int i = 0; i < count; i++)
+            target.setNumber(targetStart + i, getNumber(start + i));
+    }
+
+    @Override
+    public boolean hasIndependentSlots() {
+        return true;
+    }
+
+    @Override
+    public String toString() {
+        StringBuilder builder = new StringBuilder("[");
+        for (int i = 0; i < length(); i++) {
+            if (i > 0) builder.append(", ");
+            builder.append(Interpreter.stringify(getNumber(i)));
+        }
+        return builder.append(']').toString();
+    }
+}
@@ -0,0 +1,49 @@
+package com.aidan.cmel;
+
+import java.util.Arrays;
+
+// Bytes, as whole numbers from 0 to 255. Anything else is an error rather
+// than being wrapped or clamped.
+public final class CmelUint8Array extends CmelTypedArray {
+    private final byte[] elements;
+
+    public CmelUint8Array(int length) {
+        this.elements = new byte[length];
+    }
+
+    @Override
+    String kind() {
+        return "Uint8";
+    }
+
+    @Override
+    Object storage() {
+        return elements;
+    }
+
+    @Override
+    public double getNumber(int index) {
+        return elements[index] & 0xFF;
+    }
+
+    @Override
+    public void setNumber(int index, double value) {
+        elements[index] = check(value);
+    }
+
+    @Override
+    public int length() {
+        return elements.length;
+    }
+
+    @Override
+    public void fill(double value) {
+        Arrays.fill(elements, check(value));
+    }
+
+    private static byte check(double value) {
+        if (value != Math.floor(value) || value < 0 || value > 255)
+            throw new RuntimeError("Uint8 arrays can only hold whole numbers from 0 to 255.");
+        return (byte) (int) value;
+    }
+}
@@ -0,0 +1,385 @@
+package com.aidan.cmel;
+
+import java.io.ByteArrayInputStream;
+import java.io.DataInputStream;
+import java.io.IOException;
+import java.io.UncheckedIOException;
+import java.lang.foreign.Arena;
+import java.lang.foreign.MemorySegment;
+import java.lang.foreign.ValueLayout;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.nio.channels.FileChannel;
+import java.nio.file.Path;
+import java.nio.file.StandardOpenOption;
+import java.util.AbstractList;
+import java.util.ArrayList;
+import java.util.HashSet;
+import java.util.LinkedHashMap;
+import java.util.List;
+import java.util.Map;
+import java.util.Set;
+
+// A compiled program, written by ImageWriter as
+//
+//     int magic, int version, int sectionCount,
+//     sectionCount * (int offset, int length),
+//     sections
+//
+// where section 0 holds the top-level statements and every other section the
+// body of one named function. The file is mapped read-only rather than read,
+// so processes loading the same image share its pages through the OS page
+// cache. Loading decodes only section 0; a function's body is decoded the
+// first time something reads it, so load time depends on the size of the
+// top level rather than of the whole program.
+public final class CompiledImage {
+    static final int MAGIC = 0x434D4C49;
+    static final int VERSION = 3;
+    static final int HEADER = 3 * Integer.BYTES;
+    static final int INDEX_ENTRY = 2 * Integer.BYTES;
+
+    // Expression tags.
+    static final int ASSIGN = 1;
+    static final int TERNARY = 2;
+    static final int BINARY = 3;
+    static final int LOGICAL = 4;
+    static final int GROUPING = 5;
+    static final int LITERAL = 6;
+    static final int UNARY = 7;
+    static final int CALL = 8;
+    static final int GET = 9;
+    static final int SET = 10;
+    static final int THIS = 11;
+    static final int VARIABLE = 12;
+    static final int ANON_FUNCTION = 13;
+    static final int COMPTIME = 14;
+    static final int INDEX = 15;
+    static final int INDEX_SET = 16;
+    static final int INTERPOLATION = 17;
+    static final int LESS_THAN_CONSTANT = 18;
+    static final int INCREMENT_BY = 19;
+    static final int GET_THIS_FIELD = 20;
+    static final int CALL_VARIABLE = 21;
+
+    // Statement tags.
+    static final int BLOCK = 1;
+    static final int EXPRESSION_STATEMENT = 2;
+    static final int IF = 3;
+    static final int VAR = 4;
+    static final int WHILE = 5;
+    static final int FUNCTION = 6;
+    static final int RETURN = 7;
+    static final int CLASS = 8;
+    static final int PARALLEL_FOR = 9;
+    static final int ATOMIC = 10;
+
+    private static final ValueLayout.OfInt INT = ValueLayout.JAVA_INT_UNALIGNED.withOrder(ByteOrder.BIG_ENDIAN);
+    private static final TokenType[] TOKEN_TYPES = TokenType.values();
+
+    private final MemorySegment mapping;
+    private final int sectionCount;
+    private final Interpreter interpreter;
+
+    private CompiledImage(MemorySegment mapping, Interpreter interpreter) {
+        this.mapping = mapping;
+        this.sectionCount = mapping.get(INT, 2 * Integer.BYTES);
+        this.interpreter = interpreter;
+    }
+
+    static boolean isImage(Path path) throws IOException {
+        try (FileChannel channel = FileChannel.open(path, StandardOpenOption.READ)) {
+            ByteBuffer magic = ByteBuffer.allocate(Integer.BYTES);
+            return channel.read(magic, 0) == Integer.BYTES && magic.getInt(0) == MAGIC;
+        }
+    }
+
+    // Answers the image's top-level statements, resolved against the given
+    // interpreter.
+    static List<Statement> load(Path path, Interpreter interpreter) throws IOException {
+        MemorySegment mapping;
+        try (FileChannel channel = FileChannel.open(path, StandardOpenOption.READ)) {
+            // The mapping lives as long as something, such as a function whose
+            // body hasn't been read yet, can still reach it.
+            mapping = channel.map(FileChannel.MapMode.READ_ONLY, 0, channel.size(), Arena.ofAuto());
+        }
+        if (mapping.byteSize() < HEADER || mapping.get(INT, 0) != MAGIC)
+            throw new IOException(path + " is not a compiled image.");
+        if (mapping.get(INT, Integer.BYTES) != VERSION)
+            throw new IOException(path + " was compiled by a different version of cmel.");
+
+        return new CompiledImage(mapping, interpreter).section(0);
+    }
+
+    private List<Statement> section(int number) {
+        if (number < 0 || number >= sectionCount)
+            throw new IllegalStateException("Image has no section " + number + ".");
+        long entry = HEADER + (long) number * INDEX_ENTRY;
+        int offset = mapping.get(INT, entry);
+        int length = mapping.get(INT, entry + Integer.BYTES);
+        byte[] bytes = mapping.asSlice(offset, length).toArray(ValueLayout.JAVA_BYTE);
+
+        try {
+            return new Reader(new DataInputStream(new ByteArrayInputStream(bytes))).statements();
+        } catch (IOException e) {
+            throw new UncheckedIOException(e);
+        }
+    }
+
+    // A function body that stays in the image until it is first read, by a
+    // call or by the effect analyzer. Any thread may be first.
+    private final class LazyBody extends AbstractList<Statement> {
+        private final int number;
+        private volatile List<Statement> statements;
+
+        LazyBody(int number) {
+            this.number = number;
+        }
+
+        private List<Statement> statements() {
+            List<Statement> loaded = statements;
+            if (loaded == null) {
+                synchronized (this) {
+                    loaded = statements;
+                    if (loaded == null) statements = loaded = section(number);
+                }
+            }
+            return loaded;
+        }
+
+        @Override
+        public Statement get(int index) {
+            return statements().get(index);
+        }
+
+        @Override
+        public int size() {
+            return statements().size();
+        }
+    }
+
+    private final class Reader {
+        private final DataInputStream in;
+
+        Reader(DataInputStream in) {
+            this.in = in;
+        }
+
+        List<Statement> statements() throws IOException {
+            int count = in.readInt();
+            List<Statement> statements = new ArrayList<>(count);
+            for (int i = 0; i < count; i++) statements.add(statement());
+            return statements;
+        }
+
+        private List<Expression> expressions() throws IOException {
+            int count = in.readInt();
+            List<Expression> expressions = new ArrayList<>(count);
+            for (int i = 0; i < count; i++) expressions.add(expression());
+            return expressions;
+        }
+
+        private Token token() throws IOException {
+            TokenType type = TOKEN_TYPES[in.readUnsignedByte()];
+            String lexeme = (String) ValueCodec.read(in);
+            return new Token(type, lexeme, null, in.readInt());
+        }
+
+        private List<Token> tokens() throws IOException {
+            int count = in.readInt();
+            List<Token> tokens = new ArrayList<>(count);
+            for (int i = 0; i < count; i++) tokens.add(token());
+            return tokens;
+        }
+
+        private Token slot() throws IOException {
+            return in.readBoolean() ? token() : null;
+        }
+
+        private ScalarReplacement scalarReplacement() throws IOException {
+            int count = in.readInt();
+            if (count < 0) return null;
+            Map<String, Token> slots = new LinkedHashMap<>();
+            for (int i = 0; i < count; i++) {
+                String field = (String) ValueCodec.read(in);
+                slots.put(field, token());
+            }
+            int readCount = in.readInt();
+            Set<String> reads = new HashSet<>();
+            for (int i = 0; i < readCount; i++) reads.add((String) ValueCodec.read(in));
+            return new ScalarReplacement(slots, reads);
+        }
+
+        private <T extends Expression> T resolved(T expression) throws IOException {
+            int distance = in.readInt();
+            if (distance >= 0) interpreter.resolve(expression, distance);
+            return expression;
+        }
+
+        private Expression.Variable variable() throws IOException {
+            Expression.Variable variable = resolved(new Expression.Variable(token()));
+            variable.numberSlot = in.readInt();
+            return variable;
+        }
+
+        Expression expression() throws IOException {
+            int tag = in.readUnsignedByte();
+            return switch (tag) {
+                case 0 -> null;
+                case ASSIGN -> {
+                    Token name = token();
+                    Expression.Assign assign = resolved(new Expression.Assign(name, expression()));
+                    assign.numberSlot = in.readInt();
+                    yield assign;
+                }
+                case TERNARY -> {
+                    Expression test = expression();
+                    Token question = token();
+                    Expression left = expression();
+                    Token colon = token();
+                    yield new Expression.Ternary(test, question, left, colon, expression());
+                }
+                case BINARY -> {
+                    Expression left = expression();
+                    Token operator = token();
+                    yield new Expression.Binary(left, operator, expression());
+                }
+                case LOGICAL -> {
+                    Expression left = expression();
+                    Token operator = token();
+                    yield new Expression.Logical(left, operator, expression());
+                }
+                case GROUPING -> new Expression.Grouping(expression());
+                case LITERAL -> new Expression.Literal(ValueCodec.read(in));
+                case UNARY -> {
+                    Token operator = token();
+                    yield new Expression.Unary(operator, expression());
+                }
+                case CALL -> {
+                    Expression callee = expression();
+                    Token paren = token();
+                    yield new Expression.Call(callee, paren, expressions());
+                }
+                case GET -> {
+                    Expression object = expression();
+                    Expression.Get get = new Expression.Get(object, token());
+                    get.slot = slot();
+                    yield get;
+                }
+                case SET -> {
+                    Expression object = expression();
+                    Token name = token();
+                    Expression.Set set = new Expression.Set(object, name, expression());
+                    set.slot = slot();
+                    yield set;
+                }
+                case THIS -> resolved(new Expression.This(token()));
+                case VARIABLE -> variable();
+                case ANON_FUNCTION -> {
+                    List<Token> parameters = tokens();
+                    Expression.AnonFunction function = new Expression.AnonFunction(parameters, statements());
+                    function.hoistable = in.readBoolean();
+                    yield function;
+                }
+                case COMPTIME -> {
+                    Token keyword = token();
+                    Object value = ValueCodec.read(in);
+                    Expression.Comptime comptime = new Expression.Comptime(keyword, new Expression.Literal(value));
+                    comptime.value = value;
+                    yield comptime;
+                }
+                case INDEX -> {
+                    Expression object = expression();
+                    Token bracket = token();
+                    yield new Expression.Index(object, bracket, expression());
+                }
+                case INDEX_SET -> {
+                    Expression object = expression();
+                    Token bracket = token();
+                    Expression index = expression();
+                    yield new Expression.IndexSet(object, bracket, index, expression());
+                }
+                case INTERPOLATION -> {
+                    Token quote = token();
+                    int count = in.readInt();
+                    List<String> strings = new ArrayList<>(count);
+                    for (int i = 0; i < count; i++) strings.add((String) ValueCodec.read(in));
+                    List<Expression> values = expressions();
+                    yield new Expression.Interpolation(quote, strings, values, in.readInt());
+                }
+                case LESS_THAN_CONSTANT -> {
+                    Expression.Variable variable = (Expression.Variable) expression();
+                    Token operator = token();
+                    yield new Expression.LessThanConstant(variable, operator, in.readDouble());
+                }
+                case INCREMENT_BY -> {
+                    Expression.Variable variable = (Expression.Variable) expression();
+                    Token operator = token();
+                    yield new Expression.IncrementBy(variable, operator, in.readDouble());
+                }
+                case GET_THIS_FIELD -> {
+                    Expression.This object = (Expression.This) expression();
+                    yield new Expression.GetThisField(object, token());
+                }
+                case CALL_VARIABLE -> {
+                    Expression.Variable callee = (Expression.Variable) expression();
+                    Token paren = token();
+                    yield new Expression.CallVariable(callee, paren, expressions());
+                }
+                default -> throw new IOException("Unknown expression tag " + tag + " in image.");
+            };
+        }
+
+        Statement statement() throws IOException {
+            int tag = in.readUnsignedByte();
+            return switch (tag) {
+                case 0 -> null;
+                case BLOCK -> new Statement.Block(statements());
+                case EXPRESSION_STATEMENT -> new Statement.ExpressionStatement(expression());
+                case IF -> {
+                    Expression condition = expression();
+                    Statement thenBranch = statement();
+                    yield new Statement.IfStatement(condition, thenBranch, statement());
+                }
+                case VAR -> {
+                    Token name = token();
+                    Statement.Var statement = new Statement.Var(name, expression());
+                    statement.scalar = scalarReplacement();
+                    statement.numberSlot = in.readInt();
+                    yield statement;
+                }
+                case WHILE -> {
+                    Expression condition = expression();
+                    yield new Statement.While(condition, statement());
+                }
+                case FUNCTION -> {
+                    Token name = token();
+                    List<Token> parameters = tokens();
+                    yield new Statement.Function(name, parameters, new LazyBody(in.readInt()));
+                }
+                case RETURN -> {
+                    Token keyword = token();
+                    yield new Statement.Return(keyword, expression());
+                }
+                case CLASS -> {
+                    Token name = token();
+                    int count = in.readInt();
+                    List<Statement.Function> methods = new ArrayList<>(count);
+                    for (int i = 0; i < count; i++) methods.add((Statement.Function) statement());
+                    yield new Statement.Class(name, methods);
+                }
+                case PARALLEL_FOR -> {
+                    Token keyword = token();
+                    Token variable = token();
+                    Expression start = expression();
+                    Expression end = expression();
+                    yield new Statement.ParallelFor(keyword, variable, start, end, statement());
+                }
+                case ATOMIC -> {
+                    Token keyword = token();
+                    yield new Statement.Atomic(keyword, statement());
+                }
+                default -> throw new IOException("Unknown statement tag " + tag + " in image.");
+            };
+        }
+    }
+}
@@ -0,0 +1,17 @@
+package com.aidan.cmel;
+
+// What running a piece of code can do, from least to most observable.
+// CONCURRENT_WRITES are single atomic updates of a structure built to be
+// shared between threads: iterations of a parallel for may make them at once,
+// but a retried transaction can't undo them and comptime code can't make them.
+public enum Effect {
+    PURE, READS_GLOBALS, CONCURRENT_WRITES, WRITES, IO;
+
+    public boolean writes() {
+        return this == CONCURRENT_WRITES || this == WRITES;
+    }
+
+    public Effect join(Effect other) {
+        return compareTo(other) >= 0 ? this : other;
+    }
+}
@@ -0,0 +1,400 @@
+package com.aidan.cmel;
+
+import java.util.ArrayList;
+import java.util.HashMap;
+import java.util.HashSet;
+import java.util.List;
+import java.util.Map;
+import java.util.Set;
+
+// Classifies the body of a parallel for, and every function it can be shown to
+// call, by the most observable thing it does. Runs over the resolved AST when
+// the loop executes, so calls through globals see their current values, and
+// again whenever one of those globals has changed since.
+final class EffectAnalyzer implements Expression.Visitor<Effect>, Statement.Visitor<Effect> {
+
+    // An array a loop indexes, found through a global or a local declared
+    // outside the loop. Distance is counted from the loop's own environment.
+    static final class SharedArray {
+        final Token name;
+        final Integer distance;
+
+        SharedArray(Token name, Integer distance) {
+            this.name = name;
+            this.distance = distance;
+        }
+    }
+
+    static final class Summary {
+        final Effect effect;
+        final boolean independent;
+        final List<SharedArray> writtenArrays;
+        final List<SharedArray> readArrays;
+        // Everything from outside the loop it indexes or passes to a call.
+        final List<SharedArray> sharedValues;
+        // The global each callee was looked up as, and what it held then.
+        private final Map<String, Object> callees;
+
+        Summary(Effect effect, boolean independent, List<SharedArray> writtenArrays, List<SharedArray> readArrays,
+                List<SharedArray> sharedValues, Map<String, Object> callees) {
+            this.effect = effect;
+            this.independent = independent;
+            this.writtenArrays = writtenArrays;
+            this.readArrays = readArrays;
+            this.sharedValues = sharedValues;
+            this.callees = callees;
+        }
+
+        // Whether every callee the summary was worked out from is still what
+        // these globals hold.
+        boolean isCurrent(Environment globals) {
+            for (Map.Entry<String, Object> callee : callees.entrySet())
+                if (globals.lookup(callee.getKey()) != callee.getValue()) return false;
+            return true;
+        }
+    }
+
+    private final Interpreter interpreter;
+    private final Set<Object> analyzed = new HashSet<>();
+    private final Set<Object> analyzedAtomically = new HashSet<>();
+    private final List<SharedArray> writtenArrays = new ArrayList<>();
+    private final List<SharedArray> readArrays = new ArrayList<>();
+    private final List<SharedArray> sharedValues = new ArrayList<>();
+    private final Map<String, Object> callees = new HashMap<>();
+
+    // Scopes entered since the root being analyzed; 1 is the loop variable's
+    // scope or a called function's parameter scope.
+    private int depth;
+    private boolean inLoopBody;
+    private boolean inInitializer;
+    private boolean inAtomic = false;
+    private boolean escapes = false;
+    private boolean uncheckedReads = false;
+
+    EffectAnalyzer(Interpreter interpreter) {
+        this.interpreter = interpreter;
+    }
+
+    Summary analyze(Statement.ParallelFor loop) {
+        depth = 1;
+        inLoopBody = true;
+        inInitializer = false;
+
+        Effect effect = loop.body.accept(this);
+        boolean independent = !escapes
+                && effect.compareTo(Effect.CONCURRENT_WRITES) <= 0
+                && (writtenArrays.isEmpty() || !uncheckedReads);
+        return new Summary(effect, independent, writtenArrays, readArrays, sharedValues, callees);
+    }
+
+    private Effect analyze(Expression expression) {
+        return expression.accept(this);
+    }
+
+    private Effect analyze(Statement statement) {
+        return statement.accept(this);
+    }
+
+    private Effect analyze(List<Statement> statements) {
+        Effect effect = Effect.PURE;
+        for (Statement statement : statements)
+            effect = effect.join(analyze(statement));
+        return effect;
+    }
+
+    private Effect analyzeBody(Object declaration, List<Statement> body, boolean initializer) {
+        // Already counted elsewhere in this analysis, including recursive calls.
+        if (!(inAtomic ? analyzedAtomically : analyzed).add(declaration)) return Effect.PURE;
+
+        int enclosingDepth = depth;
+        boolean enclosingLoopBody = inLoopBody;
+        boolean enclosingInitializer = inInitializer;
+        depth = 1;
+        inLoopBody = false;
+        inInitializer = initializer;
+
+        Effect effect = analyze(body);
+
+        depth = enclosingDepth;
+        inLoopBody = enclosingLoopBody;
+        inInitializer = enclosingInitializer;
+        return effect;
+    }
+
+    private Effect effectOfCallee(Object callee) {
+        if (callee instanceof CmelFunction function)
+            return analyzeBody(function.getDeclaration(), function.getDeclaration().body, false);
+        if (callee instanceof CmelAnonFunction function)
+            return analyzeBody(function.getDeclaration(), function.getDeclaration().body, false);
+        if (callee instanceof CmelClass klass) {
+            CmelFunction initializer = klass.findMethod("init");
+            if (initializer == null) return Effect.PURE;
+            return analyzeBody(initializer.getDeclaration(), initializer.getDeclaration().body, true);
+        }
+        if (callee instanceof CmelCallable function) return function.effect();
+
+        return Effect.IO;
+    }
+
+    // Where a variable reference resolves relative to the root: null for a
+    // global, zero or less for a local declared outside it.
+    private Integer level(Expression expression) {
+        Integer distance = interpreter.depthOf(expression);
+        if (distance == null) return null;
+        return depth - distance;
+    }
+
+    private boolean isOutside(Expression expression) {
+        Integer level = level(expression);
+        return level == null || level <= 0;
+    }
+
+    private boolean isLoopVariable(Expression expression) {
+        if (!inLoopBody || !(expression instanceof Expression.Variable)) return false;
+        return isInLoopScope(expression);
+    }
+
+    private boolean isInLoopScope(Expression expression) {
+        Integer level = level(expression);
+        return level != null && level == 1;
+    }
+
+    private SharedArray sharedArray(Expression.Variable variable) {
+        Integer level = level(variable);
+        return new SharedArray(variable.name, level == null ? null : -level);
+    }
+
+    // Notes a value from outside the loop that it indexes or passes on. Only
+    // variables the loop can look up again before it runs are noted: globals
+    // anywhere, and locals from outside it in its own body.
+    private void share(Expression expression) {
+        if (!(expression instanceof Expression.Variable variable)) return;
+        Integer level = level(variable);
+        if (level == null || (inLoopBody && level <= 0)) sharedValues.add(sharedArray(variable));
+    }
+
+    // Writing the loop variable would move later a[i] = ... writes into
+    // another iteration's slot, so it counts as a write outside the loop.
+    private boolean writesShared(Expression target) {
+        return isOutside(target) || (inLoopBody && isInLoopScope(target));
+    }
+
+    @Override
+    public Effect visitAssignExpression(Expression.Assign expression) {
+        Effect effect = analyze(expression.value);
+        return writesShared(expression) ? effect.join(Effect.WRITES) : effect;
+    }
+
+    @Override
+    public Effect visitIncrementByExpression(Expression.IncrementBy expression) {
+        Effect effect = analyze(expression.variable);
+        return writesShared(expression.variable) ? effect.join(Effect.WRITES) : effect;
+    }
+
+    @Override
+    public Effect visitLessThanConstantExpression(Expression.LessThanConstant expression) {
+        return analyze(expression.variable);
+    }
+
+    @Override
+    public Effect visitTernaryExpression(Expression.Ternary expression) {
+        return analyze(expression.test).join(analyze(expression.left)).join(analyze(expression.right));
+    }
+
+    @Override
+    public Effect visitBinaryExpression(Expression.Binary expression) {
+        return analyze(expression.left).join(analyze(expression.right));
+    }
+
+    @Override
+    public Effect visitLogicalExpression(Expression.Logical expression) {
+        return analyze(expression.left).join(analyze(expression.right));
+    }
+
+    @Override
+    public Effect visitInterpolationExpression(Expression.Interpolation expression) {
+        Effect effect = Effect.PURE;
+        for (Expression value : expression.values)
+            effect = effect.join(analyze(value));
+        return effect;
+    }
+
+    @Override
+    public Effect visitGroupingExpression(Expression.Grouping expression) {
+        return analyze(expression.expression);
+    }
+
+    @Override
+    public Effect visitLiteralExpression(Expression.Literal expression) {
+        return Effect.PURE;
+    }
+
+    @Override
+    public Effect visitUnaryExpression(Expression.Unary expression) {
+        return analyze(expression.right);
+    }
+
+    @Override
+    public Effect visitCallExpression(Expression.Call expression) {
+        return analyzeCall(expression.callee, expression.arguments);
+    }
+
+    @Override
+    public Effect visitCallVariableExpression(Expression.CallVariable expression) {
+        return analyzeCall(expression.callee, expression.arguments);
+    }
+
+    private Effect analyzeCall(Expression calleeExpression, List<Expression> arguments) {
+        Effect effect = Effect.PURE;
+        for (Expression argument : arguments) {
+            effect = effect.join(analyze(argument));
+            share(argument);
+        }
+
+        // Only callees named by a global can be known before the loop runs.
+        if (calleeExpression instanceof Expression.Variable variable && level(variable) == null) {
+            Object callee = interpreter.getGlobals().lookup(variable.name.getLexeme());
+            callees.put(variable.name.getLexeme(), callee);
+            return effect.join(Effect.READS_GLOBALS).join(effectOfCallee(callee));
+        }
+
+        return effect.join(analyze(calleeExpression)).join(Effect.IO);
+    }
+
+    @Override
+    public Effect visitGetExpression(Expression.Get expression) {
+        return analyze(expression.object);
+    }
+
+    @Override
+    public Effect visitGetThisFieldExpression(Expression.GetThisField expression) {
+        return Effect.PURE;
+    }
+
+    @Override
+    public Effect visitSetExpression(Expression.Set expression) {
+        Effect effect = analyze(expression.object).join(analyze(expression.value));
+
+        // An initializer filling in the fields of the instance it is creating
+        // touches nothing another iteration can see.
+        if (inInitializer && expression.object instanceof Expression.This) return effect;
+        // Nor does one made in a transaction, which other iterations can only
+        // see whole.
+        if (inAtomic) return effect;
+        return effect.join(Effect.WRITES);
+    }
+
+    @Override
+    public Effect visitIndexExpression(Expression.Index expression) {
+        Effect effect = analyze(expression.object).join(analyze(expression.index));
+        share(expression.object);
+        if (isLoopVariable(expression.index)) return effect;
+
+        if (inLoopBody && expression.object instanceof Expression.Variable variable && isOutside(variable))
+            readArrays.add(sharedArray(variable));
+        else
+            uncheckedReads = true;
+        return effect;
+    }
+
+    @Override
+    public Effect visitIndexSetExpression(Expression.IndexSet expression) {
+        Effect effect = analyze(expression.object).join(analyze(expression.index)).join(analyze(expression.value));
+
+        // Each iteration writing only its own slot of an array from outside the
+        // loop can't conflict with any other iteration.
+        if (isLoopVariable(expression.index) && expression.object instanceof Expression.Variable variable && isOutside(variable)) {
+            writtenArrays.add(sharedArray(variable));
+            return effect;
+        }
+        return effect.join(Effect.WRITES);
+    }
+
+    @Override
+    public Effect visitThisExpression(Expression.This expression) {
+        return Effect.PURE;
+    }
+
+    @Override
+    public Effect visitVariableExpression(Expression.Variable expression) {
+        return level(expression) == null ? Effect.READS_GLOBALS : Effect.PURE;
+    }
+
+    @Override
+    public Effect visitAnonFunctionExpression(Expression.AnonFunction expression) {
+        // Creating a closure does nothing; its body is counted if it is called.
+        return Effect.PURE;
+    }
+
+    @Override
+    public Effect visitComptimeExpression(Expression.Comptime expression) {
+        return Effect.PURE;
+    }
+
+    @Override
+    public Effect visitBlockStatement(Statement.Block statement) {
+        depth++;
+        Effect effect = analyze(statement.statements);
+        depth--;
+        return effect;
+    }
+
+    @Override
+    public Effect visitExpressionStatementStatement(Statement.ExpressionStatement statement) {
+        return analyze(statement.expression);
+    }
+
+    @Override
+    public Effect visitIfStatementStatement(Statement.IfStatement statement) {
+        Effect effect = analyze(statement.condition).join(analyze(statement.thenBranch));
+        if (statement.elseBranch != null) effect = effect.join(analyze(statement.elseBranch));
+        return effect;
+    }
+
+    @Override
+    public Effect visitVarStatement(Statement.Var statement) {
+        if (statement.initializer == null) return Effect.PURE;
+        return analyze(statement.initializer);
+    }
+
+    @Override
+    public Effect visitWhileStatement(Statement.While statement) {
+        return analyze(statement.condition).join(analyze(statement.body));
+    }
+
+    @Override
+    public Effect visitAtomicStatement(Statement.Atomic statement) {
+        boolean enclosingAtomic = inAtomic;
+        inAtomic = true;
+        Effect effect = analyze(statement.body);
+        inAtomic = enclosingAtomic;
+        return effect;
+    }
+
+    @Override
+    public Effect visitParallelForStatement(Statement.ParallelFor statement) {
+        Effect effect = analyze(statement.start).join(analyze(statement.end));
+        depth++;
+        effect = effect.join(analyze(statement.body));
+        depth--;
+        return effect;
+    }
+
+    @Override
+    public Effect visitFunctionStatement(Statement.Function statement) {
+        return Effect.PURE;
+    }
+
+    @Override
+    public Effect visitReturnStatement(Statement.Return statement) {
+        // A return straight out of the loop body would have to cross threads.
+        if (inLoopBody) escapes = true;
+        if (statement.value == null) return Effect.PURE;
+        return analyze(statement.value);
+    }
+
+    @Override
+    public Effect visitClassStatement(Statement.Class statement) {
+        return Effect.PURE;
+    }
+}
@@ -1,18 +1,58 @@
 package com.aidan.cmel;
 
+import java.util.Arrays;
+import java.util.Collections;
 import java.util.HashMap;
 import java.util.Map;
+import java.util.function.BiConsumer;
 
 public class Environment {
     private final Environment enclosing;
     private final Map<String, Object> values = new HashMap<>();
+    // For pooled globals, a frozen snapshot under values: reads fall through to
+    // it, and definitions and assignments land in values, so clearing values
+    // undoes everything since the snapshot.
+    private final Map<String, Object> base;
+
+    // Locals the resolver gave a number slot keep their value unboxed in
+    // numbers while numeric says so. The first time one is given anything
+    // but a number it moves into values for good. Slot 0 is never used.
+    private double[] numbers;
+    private boolean[] numeric;
+    private String[] slotNames;
 
     public Environment() {
         enclosing = null;
+        base = null;
     }
 
     public Environment(Environment enclosing) {
         this.enclosing = enclosing;
+        this.base = null;
+    }
+
+    private Environment(Map<String, Object> base) {
+        this.enclosing = null;
+        this.base = base;
+    }
+
+    // This environment's variables as they are now, frozen so any number of
+    // overlays can share them.
+    Map<String, Object> snapshot() {
+        Map<String, Object> snapshot = new HashMap<>();
+        forEach(snapshot::put);
+        return Collections.unmodifiableMap(snapshot);
+    }
+
+    // Globals that start out as a snapshot, and can be reset back to it in
+    // time proportional to what has changed since.
+    static Environment overlay(Map<String, Object> snapshot) {
+        return new Environment(snapshot);
+    }
+
+    // Drops everything defined or assigned since the overlay was made.
+    void reset() {
+        values.clear();
     }
 
     public void define(String name, Object value) {
@@ -22,6 +62,8 @@ public class Environment {
     public Object get(Token name) {
         if (values.containsKey(name.getLexeme()))
             return values.get(name.getLexeme());
+        if (base != null && base.containsKey(name.getLexeme()))
+            return base.get(name.getLexeme());
 
         if (enclosing != null)
             return enclosing.get(name);
@@ -29,8 +71,95 @@ public class Environment {
         throw new RuntimeError(name, "Undefined variable '" + name.getLexeme() + "'.");
     }
 
+    // Like get, but answers null rather than failing for an undefined name.
+    Object lookup(String name) {
+        if (values.containsKey(name)) return values.get(name);
+        if (base != null && base.containsKey(name)) return base.get(name);
+        if (enclosing != null) return enclosing.lookup(name);
+        return null;
+    }
+
+    // The variables defined directly in this environment.
+    void forEach(BiConsumer<String, Object> action) {
+        if (base != null) {
+            base.forEach((name, value) -> {
+                if (!values.containsKey(name)) action.accept(name, value);
+            });
+        }
+        values.forEach(action);
+    }
+
     public Object getAt(int distance, String name) {
-        return ancestor(distance).values.get(name);
+        Environment environment = ancestor(distance);
+        Object value = environment.values.get(name);
+        if (value == null && environment.numbers != null) {
+            int slot = environment.slotOf(name);
+            if (slot != 0) return environment.numbers[slot];
+        }
+        return value;
+    }
+
+    void define(int slot, String name, Object value) {
+        if (!(value instanceof Double number)) {
+            values.put(name, value);
+            return;
+        }
+
+        if (numbers == null) {
+            numbers = new double[Math.max(slot + 1, 4)];
+            numeric = new boolean[numbers.length];
+            slotNames = new String[numbers.length];
+        } else if (slot >= numbers.length) {
+            int length = Math.max(slot + 1, numbers.length * 2);
+            numbers = Arrays.copyOf(numbers, length);
+            numeric = Arrays.copyOf(numeric, length);
+            slotNames = Arrays.copyOf(slotNames, length);
+        }
+        numbers[slot] = number;
+        numeric[slot] = true;
+        slotNames[slot] = name;
+    }
+
+    Object getAt(int distance, int slot, String name) {
+        Environment environment = ancestor(distance);
+        if (environment.isNumber(slot)) return environment.numbers[slot];
+        return environment.values.get(name);
+    }
+
+    boolean isNumberAt(int distance, int slot) {
+        return ancestor(distance).isNumber(slot);
+    }
+
+    // Only for a slot isNumberAt has just answered true for.
+    double numberAt(int distance, int slot) {
+        return ancestor(distance).numbers[slot];
+    }
+
+    void assignNumberAt(int distance, int slot, double value) {
+        ancestor(distance).numbers[slot] = value;
+    }
+
+    void assignAt(int distance, int slot, Token name, Object value) {
+        Environment environment = ancestor(distance);
+        if (environment.isNumber(slot)) {
+            if (value instanceof Double number) {
+                environment.numbers[slot] = number;
+                return;
+            }
+            environment.numeric[slot] = false;
+        }
+        environment.values.put(name.getLexeme(), value);
+    }
+
+    private boolean isNumber(int slot) {
+        return numeric != null && slot < numeric.length && numeric[slot];
+    }
+
+    // The slot of a local still held as a number, or 0.
+    private int slotOf(String name) {
+        for (int slot = 1; slot < slotNames.length; slot++)
+            if (numeric[slot] && name.equals(slotNames[slot])) return slot;
+        return 0;
     }
 
     private Environment ancestor(int distance) {
@@ -43,7 +172,7 @@ public class Environment {
     }
 
     public void assign(Token name, Object value) {
-        if (values.containsKey(name.getLexeme())) {
+        if (values.containsKey(name.getLexeme()) || (base != null && base.containsKey(name.getLexeme()))) {
             values.put(name.getLexeme(), value);
             return;
         }
@@ -57,6 +186,9 @@ public class Environment {
     }
 
     public void assignAt(int distance, Token name, Object value) {
-        ancestor(distance).values.put(name.getLexeme(), value);
+        Environment environment = ancestor(distance);
+        int slot = environment.numbers == null ? 0 : environment.slotOf(name.getLexeme());
+        if (slot != 0) environment.assignAt(0, slot, name, value);
+        else environment.values.put(name.getLexeme(), value);
     }
 }
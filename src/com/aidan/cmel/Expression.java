@@ -17,6 +17,14 @@ public abstract class Expression {
         R visitThisExpression(This expression);
         R visitVariableExpression(Variable expression);
         R visitAnonFunctionExpression(AnonFunction expression);
+        R visitComptimeExpression(Comptime expression);
+        R visitIndexExpression(Index expression);
+        R visitIndexSetExpression(IndexSet expression);
+        R visitInterpolationExpression(Interpolation expression);
+        R visitLessThanConstantExpression(LessThanConstant expression);
+        R visitIncrementByExpression(IncrementBy expression);
+        R visitGetThisFieldExpression(GetThisField expression);
+        R visitCallVariableExpression(CallVariable expression);
     }
 
     abstract <R> R accept(Visitor<R> visitor);
@@ -24,6 +32,7 @@ public abstract class Expression {
     static class Assign extends Expression {
         final Token name;
         final  Expression value;
+        int numberSlot;
         public Assign(Token name, Expression value) {
             this.name = name;
             this.value = value;
@@ -122,6 +131,7 @@ public abstract class Expression {
         final Expression callee;
         final  Token paren;
         final  List<Expression> arguments;
+        CallSite site;
         public Call(Expression callee, Token paren, List<Expression> arguments) {
             this.callee = callee;
             this.paren = paren;
@@ -136,6 +146,7 @@ public abstract class Expression {
     static class Get extends Expression {
         final Expression object;
         final  Token name;
+        Token slot;
         public Get(Expression object, Token name) {
             this.object = object;
             this.name = name;
@@ -150,6 +161,7 @@ public abstract class Expression {
         final Expression object;
         final  Token name;
         final  Expression value;
+        Token slot;
         public Set(Expression object, Token name, Expression value) {
             this.object = object;
             this.name = name;
@@ -174,6 +186,7 @@ public abstract class Expression {
     }
     static class Variable extends Expression {
         final Token name;
+        int numberSlot;
         public Variable(Token name) {
             this.name = name;
         }
@@ -186,6 +199,8 @@ public abstract class Expression {
     static class AnonFunction extends Expression {
         final List<Token> parameters;
         final  List<Statement> body;
+        boolean hoistable;
+        CmelAnonFunction hoisted;
         public AnonFunction(List<Token> parameters, List<Statement> body) {
             this.parameters = parameters;
             this.body = body;
@@ -196,4 +211,126 @@ public abstract class Expression {
             return visitor.visitAnonFunctionExpression(this);
         }
     }
+    static class Comptime extends Expression {
+        final Token keyword;
+        final  Expression expression;
+        Object value;
+        public Comptime(Token keyword, Expression expression) {
+            this.keyword = keyword;
+            this.expression = expression;
+        }
+
+        @Override
+        <R> R accept(Visitor<R> visitor) {
+            return visitor.visitComptimeExpression(this);
+        }
+    }
+    static class Index extends Expression {
+        final Expression object;
+        final  Token bracket;
+        final  Expression index;
+        public Index(Expression object, Token bracket, Expression index) {
+            this.object = object;
+            this.bracket = bracket;
+            this.index = index;
+        }
+
+        @Override
+        <R> R accept(Visitor<R> visitor) {
+            return visitor.visitIndexExpression(this);
+        }
+    }
+    static class IndexSet extends Expression {
+        final Expression object;
+        final  Token bracket;
+        final  Expression index;
+        final  Expression value;
+        public IndexSet(Expression object, Token bracket, Expression index, Expression value) {
+            this.object = object;
+            this.bracket = bracket;
+            this.index = index;
+            this.value = value;
+        }
+
+        @Override
+        <R> R accept(Visitor<R> visitor) {
+            return visitor.visitIndexSetExpression(this);
+        }
+    }
+    static class Interpolation extends Expression {
+        final Token quote;
+        final  List<String> strings;
+        final  List<Expression> values;
+        final  int literalLength;
+        public Interpolation(Token quote, List<String> strings, List<Expression> values, int literalLength) {
+            this.quote = quote;
+            this.strings = strings;
+            this.values = values;
+            this.literalLength = literalLength;
+        }
+
+        @Override
+        <R> R accept(Visitor<R> visitor) {
+            return visitor.visitInterpolationExpression(this);
+        }
+    }
+    static class LessThanConstant extends Expression {
+        final Variable variable;
+        final  Token operator;
+        final  double constant;
+        public LessThanConstant(Variable variable, Token operator, double constant) {
+            this.variable = variable;
+            this.operator = operator;
+            this.constant = constant;
+        }
+
+        @Override
+        <R> R accept(Visitor<R> visitor) {
+            return visitor.visitLessThanConstantExpression(this);
+        }
+    }
+    static class IncrementBy extends Expression {
+        final Variable variable;
+        final  Token operator;
+        final  double amount;
+        public IncrementBy(Variable variable, Token operator, double amount) {
+            this.variable = variable;
+            this.operator = operator;
+            this.amount = amount;
+        }
+
+        @Override
+        <R> R accept(Visitor<R> visitor) {
+            return visitor.visitIncrementByExpression(this);
+        }
+    }
+    static class GetThisField extends Expression {
+        final This object;
+        final  Token name;
+        public GetThisField(This object, Token name) {
+            this.object = object;
+            this.name = name;
+        }
+
+        @Override
+        <R> R accept(Visitor<R> visitor) {
+            return visitor.visitGetThisFieldExpression(this);
+        }
+    }
+    static class CallVariable extends Expression {
+        final Variable callee;
+        final  Token paren;
+        final  List<Expression> arguments;
+        CallSite site;
+        public CallVariable(Variable callee, Token paren, List<Expression> arguments) {
+            this.callee = callee;
+            this.paren = paren;
+            this.arguments = arguments;
+        }
+
+        @Override
+        <R> R accept(Visitor<R> visitor) {
+            return visitor.visitCallVariableExpression(this);
+        }
+    }
 }
\ No newline at end of file
@@ -0,0 +1,430 @@
+package com.aidan.cmel;
+
+import java.io.ByteArrayOutputStream;
+import java.io.DataOutputStream;
+import java.io.IOException;
+import java.io.UncheckedIOException;
+import java.nio.file.Files;
+import java.nio.file.Path;
+import java.util.ArrayList;
+import java.util.List;
+import java.util.Map;
+
+import static com.aidan.cmel.CompiledImage.*;
+
+// Writes a parsed and resolved program as a CompiledImage. Every named
+// function's body goes into a section of its own, and each variable reference
+// carries the distance the resolver found for it, so loading needs neither the
+// parser nor the resolver.
+final class ImageWriter implements Expression.Visitor<Void>, Statement.Visitor<Void> {
+    private final Interpreter interpreter;
+    private final List<byte[]> sections = new ArrayList<>();
+    private DataOutputStream out;
+
+    private ImageWriter(Interpreter interpreter) {
+        this.interpreter = interpreter;
+    }
+
+    static void write(Interpreter interpreter, List<Statement> program, Path path) throws IOException {
+        ImageWriter writer = new ImageWriter(interpreter);
+        try {
+            writer.section(program);
+        } catch (UncheckedIOException e) {
+            throw e.getCause();
+        }
+
+        ByteArrayOutputStream bytes = new ByteArrayOutputStream();
+        DataOutputStream image = new DataOutputStream(bytes);
+        image.writeInt(MAGIC);
+        image.writeInt(VERSION);
+        image.writeInt(writer.sections.size());
+        int offset = HEADER + writer.sections.size() * INDEX_ENTRY;
+        for (byte[] section : writer.sections) {
+            image.writeInt(offset);
+            image.writeInt(section.length);
+            offset += section.length;
+        }
+        for (byte[] section : writer.sections)
+            image.write(section);
+
+        Files.write(path, bytes.toByteArray());
+    }
+
+    // Writes the statements into a new section and answers its number.
+    private int section(List<Statement> statements) {
+        int number = sections.size();
+        sections.add(null);
+
+        DataOutputStream enclosing = out;
+        ByteArrayOutputStream bytes = new ByteArrayOutputStream();
+        out = new DataOutputStream(bytes);
+        statements(statements);
+        sections.set(number, bytes.toByteArray());
+        out = enclosing;
+        return number;
+    }
+
+    private void write(Expression expression) {
+        if (expression == null) writeByte(0);
+        else expression.accept(this);
+    }
+
+    private void write(Statement statement) {
+        if (statement == null) writeByte(0);
+        else statement.accept(this);
+    }
+
+    private void expressions(List<Expression> expressions) {
+        writeInt(expressions.size());
+        for (Expression expression : expressions) write(expression);
+    }
+
+    private void statements(List<Statement> statements) {
+        writeInt(statements.size());
+        for (Statement statement : statements) write(statement);
+    }
+
+    private void token(Token token) {
+        writeByte(token.getType().ordinal());
+        string(token.getLexeme());
+        writeInt(token.getLine());
+    }
+
+    private void tokens(List<Token> tokens) {
+        writeInt(tokens.size());
+        for (Token token : tokens) token(token);
+    }
+
+    private void slot(Token slot) {
+        writeByte(slot == null ? 0 : 1);
+        if (slot != null) token(slot);
+    }
+
+    private void resolution(Expression expression) {
+        Integer distance = interpreter.depthOf(expression);
+        writeInt(distance == null ? -1 : distance);
+    }
+
+    private void value(Object value) {
+        try {
+            ValueCodec.write(out, value);
+        } catch (IOException e) {
+            throw new UncheckedIOException(e);
+        }
+    }
+
+    private void string(String string) {
+        value(string);
+    }
+
+    private void writeByte(int value) {
+        try {
+            out.writeByte(value);
+        } catch (IOException e) {
+            throw new UncheckedIOException(e);
+        }
+    }
+
+    private void writeInt(int value) {
+        try {
+            out.writeInt(value);
+        } catch (IOException e) {
+            throw new UncheckedIOException(e);
+        }
+    }
+
+    private void writeDouble(double value) {
+        try {
+            out.writeDouble(value);
+        } catch (IOException e) {
+            throw new UncheckedIOException(e);
+        }
+    }
+
+    @Override
+    public Void visitAssignExpression(Expression.Assign expression) {
+        writeByte(ASSIGN);
+        token(expression.name);
+        write(expression.value);
+        resolution(expression);
+        writeInt(expression.numberSlot);
+        return null;
+    }
+
+    @Override
+    public Void visitTernaryExpression(Expression.Ternary expression) {
+        writeByte(TERNARY);
+        write(expression.test);
+        token(expression.question);
+        write(expression.left);
+        token(expression.colon);
+        write(expression.right);
+        return null;
+    }
+
+    @Override
+    public Void visitBinaryExpression(Expression.Binary expression) {
+        writeByte(BINARY);
+        write(expression.left);
+        token(expression.operator);
+        write(expression.right);
+        return null;
+    }
+
+    @Override
+    public Void visitLogicalExpression(Expression.Logical expression) {
+        writeByte(LOGICAL);
+        write(expression.left);
+        token(expression.operator);
+        write(expression.right);
+        return null;
+    }
+
+    @Override
+    public Void visitGroupingExpression(Expression.Grouping expression) {
+        writeByte(GROUPING);
+        write(expression.expression);
+        return null;
+    }
+
+    @Override
+    public Void visitLiteralExpression(Expression.Literal expression) {
+        writeByte(LITERAL);
+        value(expression.value);
+        return null;
+    }
+
+    @Override
+    public Void visitUnaryExpression(Expression.Unary expression) {
+        writeByte(UNARY);
+        token(expression.operator);
+        write(expression.right);
+        return null;
+    }
+
+    @Override
+    public Void visitCallExpression(Expression.Call expression) {
+        writeByte(CALL);
+        write(expression.callee);
+        token(expression.paren);
+        expressions(expression.arguments);
+        return null;
+    }
+
+    @Override
+    public Void visitGetExpression(Expression.Get expression) {
+        writeByte(GET);
+        write(expression.object);
+        token(expression.name);
+        slot(expression.slot);
+        return null;
+    }
+
+    @Override
+    public Void visitSetExpression(Expression.Set expression) {
+        writeByte(SET);
+        write(expression.object);
+        token(expression.name);
+        write(expression.value);
+        slot(expression.slot);
+        return null;
+    }
+
+    @Override
+    public Void visitThisExpression(Expression.This expression) {
+        writeByte(THIS);
+        token(expression.keyword);
+        resolution(expression);
+        return null;
+    }
+
+    @Override
+    public Void visitVariableExpression(Expression.Variable expression) {
+        writeByte(VARIABLE);
+        token(expression.name);
+        resolution(expression);
+        writeInt(expression.numberSlot);
+        return null;
+    }
+
+    @Override
+    public Void visitAnonFunctionExpression(Expression.AnonFunction expression) {
+        writeByte(ANON_FUNCTION);
+        tokens(expression.parameters);
+        statements(expression.body);
+        writeByte(expression.hoistable ? 1 : 0);
+        return null;
+    }
+
+    // The value was worked out when the program was compiled; only it is kept.
+    @Override
+    public Void visitComptimeExpression(Expression.Comptime expression) {
+        if (!ValueCodec.canEncode(expression.value))
+            throw new RuntimeError(expression.keyword, "Can't store the comptime value " + Interpreter.stringify(expression.value) + " in an image.");
+        writeByte(COMPTIME);
+        token(expression.keyword);
+        value(expression.value);
+        return null;
+    }
+
+    @Override
+    public Void visitIndexExpression(Expression.Index expression) {
+        writeByte(INDEX);
+        write(expression.object);
+        token(expression.bracket);
+        write(expression.index);
+        return null;
+    }
+
+    @Override
+    public Void visitIndexSetExpression(Expression.IndexSet expression) {
+        writeByte(INDEX_SET);
+        write(expression.object);
+        token(expression.bracket);
+        write(expression.index);
+        write(expression.value);
+        return null;
+    }
+
+    @Override
+    public Void visitInterpolationExpression(Expression.Interpolation expression) {
+        writeByte(INTERPOLATION);
+        token(expression.quote);
+        writeInt(expression.strings.size());
+        for (String string : expression.strings) string(string);
+        expressions(expression.values);
+        writeInt(expression.literalLength);
+        return null;
+    }
+
+    @Override
+    public Void visitLessThanConstantExpression(Expression.LessThanConstant expression) {
+        writeByte(LESS_THAN_CONSTANT);
+        write(expression.variable);
+        token(expression.operator);
+        writeDouble(expression.constant);
+        return null;
+    }
+
+    @Override
+    public Void visitIncrementByExpression(Expression.IncrementBy expression) {
+        writeByte(INCREMENT_BY);
+        write(expression.variable);
+        token(expression.operator);
+        writeDouble(expression.amount);
+        return null;
+    }
+
+    @Override
+    public Void visitGetThisFieldExpression(Expression.GetThisField expression) {
+        writeByte(GET_THIS_FIELD);
+        write(expression.object);
+        token(expression.name);
+        return null;
+    }
+
+    @Override
+    public Void visitCallVariableExpression(Expression.CallVariable expression) {
+        writeByte(CALL_VARIABLE);
+        write(expression.callee);
+        token(expression.paren);
+        expressions(expression.arguments);
+        return null;
+    }
+
+    @Override
+    public Void visitBlockStatement(Statement.Block statement) {
+        writeByte(BLOCK);
+        statements(statement.statements);
+        return null;
+    }
+
+    @Override
+    public Void visitExpressionStatementStatement(Statement.ExpressionStatement statement) {
+        writeByte(EXPRESSION_STATEMENT);
+        write(statement.expression);
+        return null;
+    }
+
+    @Override
+    public Void visitIfStatementStatement(Statement.IfStatement statement) {
+        writeByte(IF);
+        write(statement.condition);
+        write(statement.thenBranch);
+        write(statement.elseBranch);
+        return null;
+    }
+
+    @Override
+    public Void visitVarStatement(Statement.Var statement) {
+        writeByte(VAR);
+        token(statement.name);
+        write(statement.initializer);
+
+        ScalarReplacement scalar = statement.scalar;
+        writeInt(scalar == null ? -1 : scalar.slots().size());
+        if (scalar != null) {
+            for (Map.Entry<String, Token> slot : scalar.slots().entrySet()) {
+                string(slot.getKey());
+                token(slot.getValue());
+            }
+            writeInt(scalar.reads().size());
+            for (String read : scalar.reads()) string(read);
+        }
+        writeInt(statement.numberSlot);
+        return null;
+    }
+
+    @Override
+    public Void visitWhileStatement(Statement.While statement) {
+        writeByte(WHILE);
+        write(statement.condition);
+        write(statement.body);
+        return null;
+    }
+
+    @Override
+    public Void visitFunctionStatement(Statement.Function statement) {
+        writeByte(FUNCTION);
+        token(statement.name);
+        tokens(statement.parameters);
+        writeInt(section(statement.body));
+        return null;
+    }
+
+    @Override
+    public Void visitReturnStatement(Statement.Return statement) {
+        writeByte(RETURN);
+        token(statement.keyword);
+        write(statement.value);
+        return null;
+    }
+
+    @Override
+    public Void visitClassStatement(Statement.Class statement) {
+        writeByte(CLASS);
+        token(statement.name);
+        writeInt(statement.methods.size());
+        for (Statement.Function method : statement.methods) write(method);
+        return null;
+    }
+
+    @Override
+    public Void visitParallelForStatement(Statement.ParallelFor statement) {
+        writeByte(PARALLEL_FOR);
+        token(statement.keyword);
+        token(statement.variable);
+        write(statement.start);
+        write(statement.end);
+        write(statement.body);
+        return null;
+    }
+
+    @Override
+    public Void visitAtomicStatement(Statement.Atomic statement) {
+        writeByte(ATOMIC);
+        token(statement.keyword);
+        write(statement.body);
+        return null;
+    }
+}
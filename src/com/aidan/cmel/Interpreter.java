@@ -1,38 +1,253 @@
 package com.aidan.cmel;
 
+import com.aidan.cmel.collections.TransientHashMap;
+import com.aidan.cmel.collections.TransientVector;
+import com.aidan.cmel.metrics.ContextMetrics;
+import com.aidan.cmel.metrics.Metrics;
+import com.aidan.cmel.nativeFunctions.Assoc;
 import com.aidan.cmel.nativeFunctions.Clock;
+import com.aidan.cmel.nativeFunctions.CloseStore;
+import com.aidan.cmel.nativeFunctions.CloseWorkers;
+import com.aidan.cmel.nativeFunctions.Compact;
+import com.aidan.cmel.nativeFunctions.ComputeIfAbsent;
+import com.aidan.cmel.nativeFunctions.Conj;
+import com.aidan.cmel.nativeFunctions.Copy;
+import com.aidan.cmel.nativeFunctions.Count;
+import com.aidan.cmel.nativeFunctions.Delete;
+import com.aidan.cmel.nativeFunctions.Deref;
+import com.aidan.cmel.nativeFunctions.Dissoc;
+import com.aidan.cmel.nativeFunctions.Fill;
+import com.aidan.cmel.nativeFunctions.Free;
+import com.aidan.cmel.nativeFunctions.Gaussian;
+import com.aidan.cmel.nativeFunctions.GaussianFill;
+import com.aidan.cmel.nativeFunctions.Get;
+import com.aidan.cmel.nativeFunctions.Increment;
 import com.aidan.cmel.nativeFunctions.Input;
+import com.aidan.cmel.nativeFunctions.MapFile;
+import com.aidan.cmel.nativeFunctions.NewArray;
+import com.aidan.cmel.nativeFunctions.NewConcurrentMap;
+import com.aidan.cmel.nativeFunctions.NewFloat32Array;
+import com.aidan.cmel.nativeFunctions.NewFloat64Array;
+import com.aidan.cmel.nativeFunctions.NewHashMap;
+import com.aidan.cmel.nativeFunctions.NewInt32Array;
+import com.aidan.cmel.nativeFunctions.NewOffHeapArray;
+import com.aidan.cmel.nativeFunctions.NewUint8Array;
+import com.aidan.cmel.nativeFunctions.NewVector;
+import com.aidan.cmel.nativeFunctions.NewWeakMap;
+import com.aidan.cmel.nativeFunctions.NewWeakRef;
+import com.aidan.cmel.nativeFunctions.OpenStore;
+import com.aidan.cmel.nativeFunctions.Persistent;
 import com.aidan.cmel.nativeFunctions.Print;
+import com.aidan.cmel.nativeFunctions.Put;
+import com.aidan.cmel.nativeFunctions.PutIfAbsent;
+import com.aidan.cmel.nativeFunctions.Random;
+import com.aidan.cmel.nativeFunctions.RandomFill;
+import com.aidan.cmel.nativeFunctions.RandomInt;
+import com.aidan.cmel.nativeFunctions.Scan;
+import com.aidan.cmel.nativeFunctions.Seed;
+import com.aidan.cmel.nativeFunctions.Shuffle;
+import com.aidan.cmel.nativeFunctions.Transient;
+import com.aidan.cmel.nativeFunctions.WithOffHeapArray;
+import com.aidan.cmel.nativeFunctions.WorkerMap;
+import com.aidan.cmel.nativeFunctions.Workers;
 
 import java.util.ArrayList;
+import java.util.Collections;
 import java.util.HashMap;
+import java.util.IdentityHashMap;
 import java.util.List;
 import java.util.Map;
+import java.util.Set;
+import java.util.SplittableRandom;
+import java.util.concurrent.ConcurrentHashMap;
+import java.util.concurrent.ForkJoinPool;
 
 public class Interpreter implements Expression.Visitor<Object>, Statement.Visitor<Void> {
 
-    private Environment globals = new Environment();
-    private Environment environment = globals;
-    private Map<Expression, Integer> locals;
+    // What code run by this interpreter is not allowed to do, beyond the
+    // ordinary rules: compile-time, parallel and transactional code can't
+    // touch the outside world or write to globals.
+    enum Restriction { NONE, COMPTIME, PARALLEL, ATOMIC }
+
+    private final Environment globals;
+    private Environment environment;
+    private final Map<Expression, Integer> locals;
+    private Restriction restriction = Restriction.NONE;
+    private Transaction transaction = null;
+
+    // Each interpreter draws from its own generator, so parallel workers never
+    // contend for one; workers' generators are split from their parent's.
+    private SplittableRandom random;
+    private final ContextMetrics metrics;
+
+    // For pooled contexts, the expressions resolved since the last reset, so
+    // that reset can forget them again; null otherwise.
+    private final List<Expression> journal;
+
+    // The globals comptime expressions run against: these globals, under the
+    // top-level functions and classes resolved so far, none of which have run
+    // yet. Made on first use.
+    private Environment comptimeGlobals;
+
+    // For an interpreter running a comptime expression, the objects it has
+    // made, which are the only ones it may write to; null otherwise.
+    private final Set<Object> comptimeObjects;
 
     public Interpreter() {
-        locals = new HashMap<>();
+        this("default");
+    }
+
+    // Interpreters created with the same context name count into the same
+    // metrics.
+    public Interpreter(String context) {
+        metrics = Metrics.context(context);
+        globals = new Environment();
+        environment = globals;
+        // Concurrent, since a compiled image resolves a function's body the
+        // first time it is called, on whichever thread that happens.
+        locals = new ConcurrentHashMap<>();
+        random = new SplittableRandom();
+        journal = null;
         globals.define("clock", new Clock());
         globals.define("print", new Print());
         globals.define("input", new Input());
+
+        globals.define("vector", new NewVector());
+        globals.define("hashMap", new NewHashMap());
+        globals.define("get", new Get());
+        globals.define("assoc", new Assoc());
+        globals.define("conj", new Conj());
+        globals.define("dissoc", new Dissoc());
+        globals.define("count", new Count());
+        globals.define("transient", new Transient());
+        globals.define("persistent", new Persistent());
+        globals.define("array", new NewArray());
+        globals.define("float64Array", new NewFloat64Array());
+        globals.define("float32Array", new NewFloat32Array());
+        globals.define("int32Array", new NewInt32Array());
+        globals.define("uint8Array", new NewUint8Array());
+        globals.define("fill", new Fill());
+        globals.define("copy", new Copy());
+
+        globals.define("offHeapArray", new NewOffHeapArray());
+        globals.define("mapFile", new MapFile());
+        globals.define("free", new Free());
+        globals.define("withOffHeapArray", new WithOffHeapArray());
+
+        globals.define("workers", new Workers());
+        globals.define("workerMap", new WorkerMap());
+        globals.define("closeWorkers", new CloseWorkers());
+
+        globals.define("random", new Random());
+        globals.define("randomInt", new RandomInt());
+        globals.define("gaussian", new Gaussian());
+        globals.define("shuffle", new Shuffle());
+        globals.define("seed", new Seed());
+        globals.define("randomFill", new RandomFill());
+        globals.define("gaussianFill", new GaussianFill());
+
+        globals.define("openStore", new OpenStore());
+        globals.define("put", new Put());
+        globals.define("delete", new Delete());
+        globals.define("scan", new Scan());
+        globals.define("compact", new Compact());
+        globals.define("closeStore", new CloseStore());
+
+        globals.define("concurrentMap", new NewConcurrentMap());
+        globals.define("putIfAbsent", new PutIfAbsent());
+        globals.define("computeIfAbsent", new ComputeIfAbsent());
+        globals.define("increment", new Increment());
+
+        globals.define("weakRef", new NewWeakRef());
+        globals.define("deref", new Deref());
+        globals.define("weakMap", new NewWeakMap());
+    }
+
+    // A worker for one slice of a parallel for. It shares the globals and
+    // resolved locals with its parent but has its own current environment.
+    private Interpreter(Interpreter parent, Environment environment, Restriction restriction, SplittableRandom random) {
+        this.globals = parent.globals;
+        this.environment = environment;
+        this.locals = parent.locals;
+        this.restriction = restriction;
+        this.random = random;
+        this.metrics = parent.metrics;
+        this.journal = null;
+        this.comptimeObjects = null;
+    }
+
+    // Runs one comptime expression for parent.
+    private Interpreter(Interpreter parent, Environment globals) {
+        this.globals = globals;
+        this.environment = globals;
+        this.locals = parent.locals;
+        this.restriction = Restriction.COMPTIME;
+        this.random = parent.random;
+        this.metrics = parent.metrics;
+        this.journal = null;
+        this.comptimeObjects = Collections.newSetFromMap(new IdentityHashMap<>());
+    }
+
+    // A pooled context over base's globals as they are now.
+    Interpreter(Interpreter base) {
+        this(base, base.globals.snapshot());
+    }
+
+    // A pooled context over a snapshot of base's globals, which contexts made
+    // from the same base can share. It shares base's resolved locals, which
+    // already hold the prelude's, and keeps what it defines and resolves
+    // itself to one side so reset can drop it.
+    Interpreter(Interpreter base, Map<String, Object> globals) {
+        this.globals = Environment.overlay(globals);
+        this.environment = globals;
+        this.locals = base.locals;
+        this.random = new SplittableRandom();
+        this.metrics = base.metrics;
+        this.journal = new ArrayList<>();
+        this.comptimeObjects = null;
+    }
+
+    // Puts a pooled context back as it was made, in time proportional to the
+    // globals written and expressions resolved since. Objects the prelude
+    // made are shared with the base, so changes inside them are not undone.
+    void reset() {
+        globals.reset();
+        environment = globals;
+        restriction = Restriction.NONE;
+        transaction = null;
+        random = new SplittableRandom();
+        comptimeGlobals = null;
+        for (Expression expression : journal) locals.remove(expression);
+        journal.clear();
     }
 
     public void interpret(List<Statement> statements) {
+        long start = metrics.scriptStarted();
         try {
             for (Statement statement : statements) {
                 execute(statement);
             }
         } catch (RuntimeError error) {
+            metrics.runtimeError();
             Cmel.runtimeError(error);
+        } finally {
+            metrics.scriptFinished(start);
         }
     }
 
-    private String stringify(Object value) {
+    public ContextMetrics getMetrics() {
+        return metrics;
+    }
+
+    // Counts an object a script made, and answers it. Inside a comptime
+    // expression it also becomes one the expression may write to.
+    public <T> T allocated(T object) {
+        metrics.allocation();
+        if (comptimeObjects != null) comptimeObjects.add(object);
+        return object;
+    }
+
+    public static String stringify(Object value) {
         if (value == null) return "nil";
 
         if (value instanceof Double) {
@@ -46,39 +261,227 @@ public class Interpreter implements Expression.Visitor<Object>, Statement.Visito
     }
 
 
+    // Appends what stringify would answer for a number without building the
+    // intermediate String. Doubles print whole values below 10^7 without an
+    // exponent, so those can go through the long formatter.
+    private static void appendNumber(StringBuilder builder, double number) {
+        if (number == (long) number && Math.abs(number) < 1e7 && Double.compare(number, -0.0) != 0) {
+            builder.append((long) number);
+            return;
+        }
+
+        int end = builder.append(number).length();
+        if (builder.charAt(end - 2) == '.' && builder.charAt(end - 1) == '0')
+            builder.setLength(end - 2);
+    }
+
     @Override
     public Object visitAssignExpression(Expression.Assign expression) {
+        Superinstructions.unfused(Superinstructions.Pattern.INCREMENT);
         Object value = evaluate(expression.value);
+        assign(expression, expression.name, value);
+        return value;
+    }
 
+    // Stores into the variable that expression was resolved to.
+    void assign(Expression expression, Token name, Object value) {
         Integer distance = locals.get(expression);
-        if (distance != null)
-            environment.assignAt(distance, expression.name, value);
+        int slot = expression instanceof Expression.Variable variable ? variable.numberSlot
+                : expression instanceof Expression.Assign assignment ? assignment.numberSlot : 0;
+        if (distance != null && transaction != null) journal(distance, slot, name);
+        if (distance != null && slot != 0) {
+            environment.assignAt(distance, slot, name, value);
+        } else if (distance != null) {
+            environment.assignAt(distance, name, value);
+        } else {
+            checkUnrestricted(name, "assign to a global variable");
+            globals.assign(name, value);
+        }
+    }
+
+    // Inside an atomic block, arranges for a local about to be assigned to get
+    // its value back if the attempt is abandoned. A closure called in the
+    // block can assign locals the resolver couldn't see were from outside it.
+    private void journal(int distance, int slot, Token name) {
+        Environment target = environment;
+        Object previous = slot != 0 ? target.getAt(distance, slot, name.getLexeme()) : target.getAt(distance, name.getLexeme());
+        transaction.onAbort(slot != 0
+                ? () -> target.assignAt(distance, slot, name, previous)
+                : () -> target.assignAt(distance, name, previous));
+    }
+
+    @Override
+    public Object visitIncrementByExpression(Expression.IncrementBy expression) {
+        Expression.Variable variable = expression.variable;
+        if (incrementNumber(expression)) return visitVariableExpression(variable);
+
+        Superinstructions.fused(Superinstructions.Pattern.INCREMENT);
+        Object current = lookupVariable(variable.name, variable);
+
+        Object value;
+        if (current instanceof Double number)
+            value = expression.operator.getType() == TokenType.PLUS ? number + expression.amount : number - expression.amount;
+        else if (current instanceof String string && expression.operator.getType() == TokenType.PLUS)
+            value = string + stringify(expression.amount);
+        else if (expression.operator.getType() == TokenType.PLUS)
+            throw new RuntimeError(expression.operator, "Operands must be numbers or strings.");
         else
-            globals.assign(expression.name, value);
+            throw new RuntimeError(expression.operator, "Operands must be numbers.");
 
+        assign(variable, variable.name, value);
         return value;
     }
 
+    // i = i + 1 on a local held in a number slot, done without boxing; false
+    // when the variable isn't held as a number.
+    private boolean incrementNumber(Expression.IncrementBy expression) {
+        int slot = expression.variable.numberSlot;
+        if (slot == 0 || transaction != null) return false;
+        int distance = locals.get(expression.variable);
+        if (!environment.isNumberAt(distance, slot)) return false;
+
+        Superinstructions.fused(Superinstructions.Pattern.INCREMENT);
+        double current = environment.numberAt(distance, slot);
+        environment.assignNumberAt(distance, slot, expression.operator.getType() == TokenType.PLUS ? current + expression.amount : current - expression.amount);
+        return true;
+    }
+
+    // sum = sum + x as a statement, on a local held in a number slot: unboxed
+    // operands are computed without boxing, and the result is stored without
+    // boxing. False, having evaluated nothing, when it doesn't apply.
+    private boolean accumulateNumber(Expression.Assign expression) {
+        if (expression.numberSlot == 0 || transaction != null || !(expression.value instanceof Expression.Binary binary)) return false;
+        TokenType operator = binary.operator.getType();
+        if (operator != TokenType.PLUS && operator != TokenType.MINUS && operator != TokenType.STAR && operator != TokenType.SLASH)
+            return false;
+        int distance = locals.get(expression);
+        if (!environment.isNumberAt(distance, expression.numberSlot)) return false;
+
+        Superinstructions.unfused(Superinstructions.Pattern.INCREMENT);
+        boolean leftUnboxed = unboxed(binary.left);
+        Object left = leftUnboxed ? null : evaluate(binary.left);
+        double l = leftUnboxed ? number(binary.left) : 0;
+        boolean rightUnboxed = unboxed(binary.right);
+        Object right = rightUnboxed ? null : evaluate(binary.right);
+        double r = rightUnboxed ? number(binary.right) : 0;
+
+        if ((!leftUnboxed && !(left instanceof Double)) || (!rightUnboxed && !(right instanceof Double))) {
+            assign(expression, expression.name, binary(binary.operator, leftUnboxed ? l : left, rightUnboxed ? r : right));
+            return true;
+        }
+        if (!leftUnboxed) l = (Double) left;
+        if (!rightUnboxed) r = (Double) right;
+
+        double value = switch (operator) {
+            case PLUS -> l + r;
+            case MINUS -> l - r;
+            case STAR -> l * r;
+            default -> {
+                if (r == 0) throw new RuntimeError(binary.operator, "Cannot divide by zero.");
+                yield l / r;
+            }
+        };
+        if (environment.isNumberAt(distance, expression.numberSlot)) environment.assignNumberAt(distance, expression.numberSlot, value);
+        else assign(expression, expression.name, value);
+        return true;
+    }
+
+    // Whether expression is a local whose number slot still holds a number.
+    private boolean inNumberSlot(Expression expression) {
+        return expression instanceof Expression.Variable variable && variable.numberSlot != 0
+                && environment.isNumberAt(locals.get(variable), variable.numberSlot);
+    }
+
+    private double readNumber(Expression.Variable variable) {
+        return environment.numberAt(locals.get(variable), variable.numberSlot);
+    }
+
+    // Whether expression can be computed as a double without boxing: a number
+    // literal, a local in a number slot, an element of a typed array held in
+    // a variable, or arithmetic on those. None of them has side effects, so
+    // checking and then computing sees the same values.
+    private boolean unboxed(Expression expression) {
+        if (expression instanceof Expression.Literal literal) return literal.value instanceof Double;
+        if (expression instanceof Expression.Grouping grouping) return unboxed(grouping.expression);
+        if (expression instanceof Expression.Variable) return inNumberSlot(expression);
+        if (expression instanceof Expression.Index index)
+            return index.object instanceof Expression.Variable variable
+                    && lookupVariable(variable.name, variable) instanceof CmelTypedArray
+                    && unboxed(index.index);
+        if (expression instanceof Expression.Binary binary) {
+            TokenType operator = binary.operator.getType();
+            return (operator == TokenType.PLUS || operator == TokenType.MINUS
+                    || operator == TokenType.STAR || operator == TokenType.SLASH)
+                    && unboxed(binary.left) && unboxed(binary.right);
+        }
+        return false;
+    }
+
+    // The value of an expression unboxed says can be computed without boxing.
+    private double number(Expression expression) {
+        if (expression instanceof Expression.Literal literal) return (Double) literal.value;
+        if (expression instanceof Expression.Grouping grouping) return number(grouping.expression);
+        if (expression instanceof Expression.Variable variable) return readNumber(variable);
+        if (expression instanceof Expression.Index index) {
+            Expression.Variable variable = (Expression.Variable) index.object;
+            CmelTypedArray array = (CmelTypedArray) lookupVariable(variable.name, variable);
+            try {
+                return array.getNumber(CmelIndexable.toIndex(number(index.index), array.length()));
+            } catch (RuntimeError error) {
+                throw locate(error, index.bracket);
+            }
+        }
+
+        Expression.Binary binary = (Expression.Binary) expression;
+        double l = number(binary.left);
+        double r = number(binary.right);
+        return switch (binary.operator.getType()) {
+            case PLUS -> l + r;
+            case MINUS -> l - r;
+            case STAR -> l * r;
+            default -> {
+                if (r == 0) throw new RuntimeError(binary.operator, "Cannot divide by zero.");
+                yield l / r;
+            }
+        };
+    }
+
+    @Override
+    public Object visitLessThanConstantExpression(Expression.LessThanConstant expression) {
+        Superinstructions.fused(Superinstructions.Pattern.LESS_THAN_CONSTANT);
+        if (inNumberSlot(expression.variable))
+            return readNumber(expression.variable) < expression.constant;
+
+        Object value = lookupVariable(expression.variable.name, expression.variable);
+        if (!(value instanceof Double number))
+            throw new RuntimeError(expression.operator, "Operands must be numbers.");
+        return number < expression.constant;
+    }
+
     @Override
     public Object visitBinaryExpression(Expression.Binary expression) {
         Object left = evaluate(expression.left);
         Object right = evaluate(expression.right);
+        return binary(expression.operator, left, right);
+    }
 
-        switch (expression.operator.getType()) {
+    private Object binary(Token operator, Object left, Object right) {
+        switch (operator.getType()) {
             case GREATER -> {
-                checkNumberOperands(expression.operator, left, right);
+                checkNumberOperands(operator, left, right);
                 return (double)left > (double)right;
             }
             case GREATER_EQUAL -> {
-                checkNumberOperands(expression.operator, left, right);
+                checkNumberOperands(operator, left, right);
                 return (double)left >= (double)right;
             }
             case LESS -> {
-                checkNumberOperands(expression.operator, left, right);
+                Superinstructions.unfused(Superinstructions.Pattern.LESS_THAN_CONSTANT);
+                checkNumberOperands(operator, left, right);
                 return (double)left < (double)right;
             }
             case LESS_EQUAL -> {
-                checkNumberOperands(expression.operator, left, right);
+                checkNumberOperands(operator, left, right);
                 return (double)left <= (double)right;
             }
 
@@ -86,17 +489,17 @@ public class Interpreter implements Expression.Visitor<Object>, Statement.Visito
             case EQUAL_EQUAL -> { return isEqual(left, right); }
 
             case MINUS -> {
-                checkNumberOperands(expression.operator, left, right);
+                checkNumberOperands(operator, left, right);
                 return (double)left - (double)right;
             }
             case SLASH -> {
-                checkNumberOperands(expression.operator, left, right);
+                checkNumberOperands(operator, left, right);
                 if ((double) right == 0)
-                    throw new RuntimeError(expression.operator, "Cannot divide by zero.");
+                    throw new RuntimeError(operator, "Cannot divide by zero.");
                 return (double)left / (double)right;
             }
             case STAR  -> {
-                checkNumberOperands(expression.operator, left, right);
+                checkNumberOperands(operator, left, right);
                 return (double)left * (double)right;
             }
             case PLUS -> {
@@ -109,7 +512,7 @@ public class Interpreter implements Expression.Visitor<Object>, Statement.Visito
                 if (left instanceof Double l && right instanceof String r)
                     return stringify(l) + r;
 
-                throw new RuntimeError(expression.operator, "Operands must be numbers or strings.");
+                throw new RuntimeError(operator, "Operands must be numbers or strings.");
             }
         }
         return null;
@@ -128,6 +531,31 @@ public class Interpreter implements Expression.Visitor<Object>, Statement.Visito
         return evaluate(expression.right);
     }
 
+    // Builds the whole string in one builder sized up front, with numbers
+    // formatted straight into it.
+    @Override
+    public Object visitInterpolationExpression(Expression.Interpolation expression) {
+        List<Expression> values = expression.values;
+        Object[] evaluated = new Object[values.size()];
+        int capacity = expression.literalLength;
+        for (int i = 0; i < evaluated.length; i++) {
+            Object value = evaluate(values.get(i));
+            if (!(value instanceof String) && !(value instanceof Double)) value = stringify(value);
+            evaluated[i] = value;
+            capacity += value instanceof String string ? string.length() : 24;
+        }
+
+        StringBuilder builder = new StringBuilder(capacity);
+        List<String> strings = expression.strings;
+        builder.append(strings.get(0));
+        for (int i = 0; i < evaluated.length; i++) {
+            if (evaluated[i] instanceof Double number) appendNumber(builder, number);
+            else builder.append((String) evaluated[i]);
+            builder.append(strings.get(i + 1));
+        }
+        return builder.toString();
+    }
+
     @Override
     public Object visitGroupingExpression(Expression.Grouping expression) {
         return evaluate(expression.expression);
@@ -156,20 +584,99 @@ public class Interpreter implements Expression.Visitor<Object>, Statement.Visito
 
     @Override
     public Object visitCallExpression(Expression.Call expression) {
+        Superinstructions.unfused(Superinstructions.Pattern.CALL_VARIABLE);
         Object callee = evaluate(expression.callee);
+        List<Object> arguments = evaluateArguments(expression.arguments);
+
+        CallSite site = expression.site;
+        if (site != null && site.matches(callee)) {
+            metrics.cacheHit();
+            return invoke(expression.paren, site.kind, (CmelCallable) callee, arguments);
+        }
+
+        metrics.cacheMiss();
+        CmelCallable function = checkCall(expression.paren, callee, arguments);
+        if (site != null && site.isMegamorphic())
+            return invoke(expression.paren, CallSite.Kind.GENERIC, function, arguments);
+
+        site = new CallSite(function, site == null ? 0 : site.misses + 1);
+        expression.site = site;
+        return invoke(expression.paren, site.kind, function, arguments);
+    }
+
+    // The same as a Call whose callee is a Variable, without dispatching on
+    // the callee node.
+    @Override
+    public Object visitCallVariableExpression(Expression.CallVariable expression) {
+        Superinstructions.fused(Superinstructions.Pattern.CALL_VARIABLE);
+        Object callee = lookupVariable(expression.callee.name, expression.callee);
+        List<Object> arguments = evaluateArguments(expression.arguments);
+
+        CallSite site = expression.site;
+        if (site != null && site.matches(callee)) {
+            metrics.cacheHit();
+            return invoke(expression.paren, site.kind, (CmelCallable) callee, arguments);
+        }
+
+        metrics.cacheMiss();
+        CmelCallable function = checkCall(expression.paren, callee, arguments);
+        if (site != null && site.isMegamorphic())
+            return invoke(expression.paren, CallSite.Kind.GENERIC, function, arguments);
+
+        site = new CallSite(function, site == null ? 0 : site.misses + 1);
+        expression.site = site;
+        return invoke(expression.paren, site.kind, function, arguments);
+    }
 
-        List<Object> arguments = new ArrayList<>();
-        for (Expression argument : expression.arguments)
+    private List<Object> evaluateArguments(List<Expression> expressions) {
+        List<Object> arguments = new ArrayList<>(expressions.size());
+        for (Expression argument : expressions)
             arguments.add(evaluate(argument));
+        return arguments;
+    }
 
+    private CmelCallable checkCall(Token paren, Object callee, List<Object> arguments) {
         if (!(callee instanceof CmelCallable))
-            throw new RuntimeError(expression.paren, "Can only call functions and classes");
+            throw new RuntimeError(paren, "Can only call functions and classes");
 
         CmelCallable function = (CmelCallable) callee;
 
         if (arguments.size() != function.arity())
-            throw new RuntimeError(expression.paren, "Expected " + function.arity() + " arguments, but got " + arguments.size() + " instead.");
-        return function.call(this, arguments);
+            throw new RuntimeError(paren, "Expected " + function.arity() + " arguments, but got " + arguments.size() + " instead.");
+        return function;
+    }
+
+    private Object invoke(Token paren, CallSite.Kind kind, CmelCallable function, List<Object> arguments) {
+        metrics.call();
+        try {
+            return switch (kind) {
+                case FUNCTION -> ((CmelFunction) function).call(this, arguments);
+                case ANONYMOUS_FUNCTION -> ((CmelAnonFunction) function).call(this, arguments);
+                case CLASS -> ((CmelClass) function).call(this, arguments);
+                case GENERIC -> {
+                    Effect effect = function.effect(arguments);
+                    if (effect == Effect.IO)
+                        checkUnrestricted(paren, "call an impure function");
+                    if (effect.writes() && restriction == Restriction.COMPTIME && !madeAtComptime(arguments))
+                        throw new RuntimeError(paren, "Can't call a function that writes to its arguments at compile time.");
+                    if (effect.writes() && transaction != null)
+                        throw new RuntimeError(paren, "Can't call a function that writes to its arguments inside an atomic block.");
+                    yield function.call(this, arguments);
+                }
+            };
+        } catch (RuntimeError error) {
+            if (error.getToken() != null) throw error;
+            throw new RuntimeError(paren, error.getMessage());
+        }
+    }
+
+    private void checkUnrestricted(Token token, String action) {
+        switch (restriction) {
+            case NONE -> {}
+            case COMPTIME -> throw new RuntimeError(token, "Can't " + action + " at compile time.");
+            case PARALLEL -> throw new RuntimeError(token, "Can't " + action + " inside a parallel for.");
+            case ATOMIC -> throw new RuntimeError(token, "Can't " + action + " inside an atomic block.");
+        }
     }
 
     @Override
@@ -183,6 +690,8 @@ public class Interpreter implements Expression.Visitor<Object>, Statement.Visito
 
     @Override
     public Object visitVariableExpression(Expression.Variable expression) {
+        if (expression.numberSlot != 0)
+            return environment.getAt(locals.get(expression), expression.numberSlot, expression.name.getLexeme());
         return lookupVariable(expression.name, expression);
     }
 
@@ -196,7 +705,59 @@ public class Interpreter implements Expression.Visitor<Object>, Statement.Visito
 
     @Override
     public Object visitAnonFunctionExpression(Expression.AnonFunction expression) {
-        return new CmelAnonFunction(expression, environment);
+        if (!expression.hoistable)
+            return new CmelAnonFunction(expression, environment);
+
+        if (expression.hoisted == null)
+            expression.hoisted = new CmelAnonFunction(expression, globals);
+        return expression.hoisted;
+    }
+
+    @Override
+    public Object visitComptimeExpression(Expression.Comptime expression) {
+        return expression.value;
+    }
+
+    // Runs a comptime expression against the globals and stores its result on
+    // the node, which then evaluates to it like a literal.
+    void evaluateComptime(Expression.Comptime expression) {
+        try {
+            expression.value = new Interpreter(this, comptimeGlobals()).evaluate(expression.expression);
+        } catch (RuntimeError error) {
+            Token token = error.getToken() != null ? error.getToken() : expression.keyword;
+            Cmel.error(token, error.getMessage());
+        }
+    }
+
+    // Defines a top-level function or class for comptime expressions resolved
+    // after it to call, ahead of the program running.
+    void declareForComptime(Statement statement) {
+        Environment previous = environment;
+        try {
+            environment = comptimeGlobals();
+            execute(statement);
+        } finally {
+            environment = previous;
+        }
+    }
+
+    private Environment comptimeGlobals() {
+        if (comptimeGlobals == null) comptimeGlobals = new Environment(globals);
+        return comptimeGlobals;
+    }
+
+    // Compile-time code may only write to objects it made itself.
+    // Whether every array or collection among arguments was made by the
+    // comptime expression running, so a native may write to any of them.
+    private boolean madeAtComptime(List<Object> arguments) {
+        for (Object argument : arguments)
+            if (argument instanceof CmelIndexable && !comptimeObjects.contains(argument)) return false;
+        return true;
+    }
+
+    private void checkComptimeWrite(Token token, Object object) {
+        if (comptimeObjects != null && !comptimeObjects.contains(object))
+            throw new RuntimeError(token, "Can't write to an object made outside a comptime expression at compile time.");
     }
 
     @Override
@@ -227,6 +788,13 @@ public class Interpreter implements Expression.Visitor<Object>, Statement.Visito
 
     @Override
     public Void visitExpressionStatementStatement(Statement.ExpressionStatement statement) {
+        // The value of a statement is thrown away, so these needn't box it.
+        if (statement.expression instanceof Expression.IncrementBy increment && incrementNumber(increment)) return null;
+        if (statement.expression instanceof Expression.Assign assignment && accumulateNumber(assignment)) return null;
+        if (statement.expression instanceof Expression.IndexSet set) {
+            indexSet(set, false);
+            return null;
+        }
         evaluate(statement.expression);
         return null;
     }
@@ -242,22 +810,137 @@ public class Interpreter implements Expression.Visitor<Object>, Statement.Visito
 
     @Override
     public Void visitVarStatement(Statement.Var statement) {
+        if (statement.scalar != null && statement.scalar.instantiate(this, statement, environment)) return null;
+
         Object value = null;
         if (statement.initializer != null)
             value = evaluate(statement.initializer);
 
-        environment.define(statement.name.getLexeme(), value);
+        if (statement.numberSlot != 0) environment.define(statement.numberSlot, statement.name.getLexeme(), value);
+        else environment.define(statement.name.getLexeme(), value);
         return null;
     }
 
     @Override
     public Void visitWhileStatement(Statement.While statement) {
+        if (!statement.kernelChecked) {
+            statement.kernel = ArrayKernel.match(statement);
+            statement.kernelChecked = true;
+        }
+        // The kernel writes arrays and locals directly, past the checks and
+        // journal that comptime, parallel and atomic code rely on.
+        if (statement.kernel != null && restriction == Restriction.NONE && transaction == null
+                && statement.kernel.run(this)) return null;
+
         while (isTruthy(evaluate(statement.condition))) {
             execute(statement.body);
         }
         return null;
     }
 
+    @Override
+    public Void visitAtomicStatement(Statement.Atomic statement) {
+        // A nested block is just part of the enclosing transaction.
+        if (transaction != null) {
+            execute(statement.body);
+            return null;
+        }
+
+        Restriction enclosingRestriction = restriction;
+        if (restriction == Restriction.NONE) restriction = Restriction.ATOMIC;
+        try {
+            for (int attempt = 0; ; attempt++) {
+                transaction = new Transaction();
+                boolean committed = false;
+                try {
+                    execute(statement.body);
+                    committed = transaction.commit();
+                    if (committed) return null;
+                } catch (Return returned) {
+                    committed = transaction.commit();
+                    if (committed) throw returned;
+                } catch (Transaction.Conflict conflict) {
+                    // Run the block again from the start.
+                } finally {
+                    if (!committed) transaction.rollBack();
+                }
+                Transaction.backoff(attempt);
+            }
+        } finally {
+            transaction = null;
+            restriction = enclosingRestriction;
+        }
+    }
+
+    @Override
+    public Void visitParallelForStatement(Statement.ParallelFor statement) {
+        Object start = evaluate(statement.start);
+        Object end = evaluate(statement.end);
+        checkNumberOperands(statement.keyword, start, end);
+
+        double first = (double) start;
+        long count = (long) Math.ceil((double) end - first);
+        if (count <= 0) return null;
+
+        if (statement.summary == null || !statement.summary.isCurrent(globals))
+            statement.summary = new EffectAnalyzer(this).analyze(statement);
+
+        SplittableRandom loopRandom = random.split();
+        if (restriction == Restriction.NONE && count > 1 && canRunInParallel(statement.summary))
+            ForkJoinPool.commonPool().invoke(new ParallelRange(this, statement, first, count, loopRandom));
+        else
+            ParallelRange.runSerially(this, statement, first, count, loopRandom);
+        return null;
+    }
+
+    // The analysis only knows which variables the loop writes through; check
+    // now that they really hold arrays whose slots are independent, that no
+    // array the loop reads out of step is one it also writes, and that it
+    // touches no transient, which only the thread that made it may use.
+    private boolean canRunInParallel(EffectAnalyzer.Summary summary) {
+        if (!summary.independent) return false;
+
+        for (EffectAnalyzer.SharedArray shared : summary.sharedValues) {
+            Object value = valueOf(shared);
+            if (value instanceof TransientHashMap || value instanceof TransientVector) return false;
+        }
+
+        List<Object> written = new ArrayList<>();
+        for (EffectAnalyzer.SharedArray array : summary.writtenArrays) {
+            Object value = valueOf(array);
+            if (!(value instanceof CmelIndexable indexable) || !indexable.hasIndependentSlots()) return false;
+            written.add(value);
+        }
+
+        for (EffectAnalyzer.SharedArray array : summary.readArrays) {
+            Object value = valueOf(array);
+            for (Object other : written)
+                if (other == value) return false;
+        }
+        return true;
+    }
+
+    private Object valueOf(EffectAnalyzer.SharedArray array) {
+        if (array.distance == null) return globals.lookup(array.name.getLexeme());
+        return environment.getAt(array.distance, array.name.getLexeme());
+    }
+
+    // Runs iterations [lo, hi) of a parallel for whose loop variable starts at
+    // first, drawing random numbers from the given generator.
+    void runIterations(Statement.ParallelFor statement, double first, long lo, long hi, SplittableRandom random) {
+        SplittableRandom enclosing = this.random;
+        this.random = random;
+        try {
+            for (long i = lo; i < hi; i++) {
+                Environment iteration = new Environment(environment);
+                iteration.define(statement.variable.getLexeme(), first + i);
+                executeBlock(List.of(statement.body), iteration);
+            }
+        } finally {
+            this.random = enclosing;
+        }
+    }
+
     @Override
     public Void visitFunctionStatement(Statement.Function statement) {
         CmelFunction function = new CmelFunction(statement, environment, false);
@@ -275,24 +958,114 @@ public class Interpreter implements Expression.Visitor<Object>, Statement.Visito
 
     @Override
     public Object visitGetExpression(Expression.Get expression) {
+        Superinstructions.unfused(Superinstructions.Pattern.THIS_FIELD);
         Object object = evaluate(expression.object);
         if (object instanceof CmelInstance) {
-            return ((CmelInstance) object).get(expression.name);
+            return ((CmelInstance) object).get(expression.name, transaction);
+        }
+        if (object == ScalarReplacement.REPLACED) {
+            Object value = environment.getAt(locals.get(expression.object), expression.slot.getLexeme());
+            if (value == ScalarReplacement.ABSENT)
+                throw new RuntimeError(expression.name, "Undefined property '" + expression.name.getLexeme() + "'.");
+            return value;
         }
 
         throw new RuntimeError(expression.name, "Only instances have properties");
     }
 
+    @Override
+    public Object visitIndexExpression(Expression.Index expression) {
+        if (unboxed(expression)) return number(expression);
+
+        Object object = evaluate(expression.object);
+        Object index = evaluate(expression.index);
+
+        if (!(object instanceof CmelIndexable))
+            throw new RuntimeError(expression.bracket, "Only arrays and collections can be indexed.");
+
+        try {
+            return ((CmelIndexable) object).get(index);
+        } catch (RuntimeError error) {
+            throw locate(error, expression.bracket);
+        }
+    }
+
+    @Override
+    public Object visitIndexSetExpression(Expression.IndexSet expression) {
+        return indexSet(expression, true);
+    }
+
+    // Stores into a typed array without boxing when the index and value are
+    // unboxed; the stored value is only boxed when it is used.
+    private Object indexSet(Expression.IndexSet expression, boolean used) {
+        Object object = evaluate(expression.object);
+        if (object instanceof CmelIndexable) checkComptimeWrite(expression.bracket, object);
+        if (object instanceof CmelIndexable && transaction != null)
+            throw new RuntimeError(expression.bracket, "Can't write to an array or collection inside an atomic block.");
+
+        if (object instanceof CmelTypedArray array && unboxed(expression.index)) {
+            double index = number(expression.index);
+            if (unboxed(expression.value)) {
+                double value = number(expression.value);
+                try {
+                    array.setNumber(CmelIndexable.toIndex(index, array.length()), value);
+                } catch (RuntimeError error) {
+                    throw locate(error, expression.bracket);
+                }
+                return used ? value : null;
+            }
+
+            Object value = evaluate(expression.value);
+            try {
+                array.set(CmelIndexable.toIndex(index, array.length()), value);
+            } catch (RuntimeError error) {
+                throw locate(error, expression.bracket);
+            }
+            return value;
+        }
+
+        Object index = evaluate(expression.index);
+
+        if (!(object instanceof CmelIndexable))
+            throw new RuntimeError(expression.bracket, "Only arrays and collections can be indexed.");
+
+        Object value = evaluate(expression.value);
+        try {
+            ((CmelIndexable) object).set(index, value);
+        } catch (RuntimeError error) {
+            throw locate(error, expression.bracket);
+        }
+        return value;
+    }
+
+    private static RuntimeError locate(RuntimeError error, Token token) {
+        if (error.getToken() != null) return error;
+        return new RuntimeError(token, error.getMessage());
+    }
+
+    @Override
+    public Object visitGetThisFieldExpression(Expression.GetThisField expression) {
+        Superinstructions.fused(Superinstructions.Pattern.THIS_FIELD);
+        Object object = lookupVariable(expression.object.keyword, expression.object);
+        return ((CmelInstance) object).get(expression.name, transaction);
+    }
+
     @Override
     public Object visitSetExpression(Expression.Set expression) {
         Object object = evaluate(expression.object);
+        if (object == ScalarReplacement.REPLACED) {
+            Object value = evaluate(expression.value);
+            environment.assignAt(locals.get(expression.object), expression.slot, value);
+            return value;
+        }
 
         if (!(object instanceof CmelInstance)) {
             throw new RuntimeError(expression.name, "Only instances have fields.");
         }
+        checkComptimeWrite(expression.name, object);
 
         Object value = evaluate(expression.value);
-        ((CmelInstance) object).set(expression.name, value);
+        ((CmelInstance) object).set(expression.name, value, transaction);
         return value;
     }
 
@@ -319,7 +1092,7 @@ public class Interpreter implements Expression.Visitor<Object>, Statement.Visito
         return true;
     }
 
-    private Object evaluate(Expression expression) {
+    Object evaluate(Expression expression) {
         return expression.accept(this);
     }
 
@@ -338,11 +1111,28 @@ public class Interpreter implements Expression.Visitor<Object>, Statement.Visito
         }
     }
 
+    public SplittableRandom getRandom() {
+        return random;
+    }
+
+    public void seed(long seed) {
+        random = new SplittableRandom(seed);
+    }
+
     public Environment getGlobals() {
         return globals;
     }
 
     public void resolve(Expression expression, int depth) {
         locals.put(expression, depth);
+        if (journal != null) journal.add(expression);
+    }
+
+    Interpreter fork(SplittableRandom random) {
+        return new Interpreter(this, environment, Restriction.PARALLEL, random);
+    }
+
+    Integer depthOf(Expression expression) {
+        return locals.get(expression);
     }
 }
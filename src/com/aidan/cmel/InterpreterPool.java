@@ -0,0 +1,77 @@
+package com.aidan.cmel;
+
+import java.util.List;
+import java.util.Map;
+import java.util.concurrent.ArrayBlockingQueue;
+import java.util.concurrent.BlockingQueue;
+
+// Contexts for running many short scripts, each starting from the same state:
+// the natives plus whatever a prelude defined. The prelude is parsed, resolved
+// and run once; every context's globals are a copy-on-write overlay on one
+// shared snapshot of the result, so making one copies nothing, and handing one
+// back only undoes what its script wrote.
+//
+// Only bindings are copy-on-write. An instance, array or map the prelude made
+// is the same object in every context, so a script that changes one inside
+// changes it for all of them.
+public final class InterpreterPool {
+    private final Interpreter base;
+    // The prelude's globals, taken once and shared by every context.
+    private final Map<String, Object> globals;
+    private final BlockingQueue<Interpreter> idle;
+
+    public InterpreterPool(String context, String prelude, int size) {
+        base = new Interpreter(context);
+        Parser parser = new Parser(new Scanner(prelude), new Resolver(base));
+        List<Statement> statements = parser.parse();
+        if (parser.hadError())
+            throw new IllegalArgumentException("The prelude doesn't compile.");
+        base.interpret(statements);
+        globals = base.getGlobals().snapshot();
+
+        idle = new ArrayBlockingQueue<>(size);
+        for (int i = 0; i < size; i++)
+            idle.add(new Interpreter(base, globals));
+    }
+
+    // Answers an idle context, or a new one when all are in use.
+    public Lease acquire() {
+        Interpreter interpreter = idle.poll();
+        return new Lease(interpreter != null ? interpreter : new Interpreter(base, globals));
+    }
+
+    public int idle() {
+        return idle.size();
+    }
+
+    public final class Lease implements AutoCloseable {
+        private Interpreter interpreter;
+
+        private Lease(Interpreter interpreter) {
+            this.interpreter = interpreter;
+        }
+
+        // Errors are reported as Cmel reports them; a script with a scanner,
+        // parser or resolver error isn't run.
+        public void run(String source) {
+            if (interpreter == null) throw new IllegalStateException("The lease has been closed.");
+            Parser parser = new Parser(new Scanner(source), new Resolver(interpreter));
+            List<Statement> statements = parser.parse();
+            if (parser.hadError()) return;
+            interpreter.interpret(statements);
+        }
+
+        public Interpreter interpreter() {
+            return interpreter;
+        }
+
+        // Resets the context and puts it back, unless the pool is already full.
+        @Override
+        public void close() {
+            if (interpreter == null) return;
+            interpreter.reset();
+            idle.offer(interpreter);
+            interpreter = null;
+        }
+    }
+}
@@ -0,0 +1,202 @@
+package com.aidan.cmel;
+
+import java.util.ArrayList;
+import java.util.LinkedHashMap;
+import java.util.List;
+import java.util.Map;
+
+// Just enough JSON for the language server's messages: objects are Maps,
+// arrays Lists, numbers Doubles.
+final class Json {
+    private final String text;
+    private int current = 0;
+
+    private Json(String text) {
+        this.text = text;
+    }
+
+    static Object parse(String text) {
+        Json json = new Json(text);
+        Object value = json.value();
+        json.whitespace();
+        if (json.current != text.length()) throw json.error("Unexpected trailing characters");
+        return value;
+    }
+
+    static String write(Object value) {
+        StringBuilder builder = new StringBuilder();
+        write(builder, value);
+        return builder.toString();
+    }
+
+    private static void write(StringBuilder builder, Object value) {
+        if (value == null) {
+            builder.append("null");
+        } else if (value instanceof String string) {
+            string(builder, string);
+        } else if (value instanceof Double number) {
+            if (number == Math.rint(number) && Math.abs(number) < 1e15) builder.append(number.longValue());
+            else builder.append(number);
+        } else if (value instanceof Number || value instanceof Boolean) {
+            builder.append(value);
+        } else if (value instanceof Map<?, ?> map) {
+            builder.append('{');
+            boolean first = true;
+            for (Map.Entry<?, ?> entry : map.entrySet()) {
+                if (!first) builder.append(',');
+                first = false;
+                string(builder, (String) entry.getKey());
+                builder.append(':');
+                write(builder, entry.getValue());
+            }
+            builder.append('}');
+        } else if (value instanceof List<?> list) {
+            builder.append('[');
+            for (int i = 0; i < list.size(); i++) {
+                if (i > 0) builder.append(',');
+                write(builder, list.get(i));
+            }
+            builder.append(']');
+        } else {
+            throw new IllegalArgumentException("Can't write " + value.getClass().getSimpleName() + " as JSON.");
+        }
+    }
+
+    private static void string(StringBuilder builder, String string) {
+        builder.append('"');
+        for (int i = 0; i < string.length(); i++) {
+            char c = string.charAt(i);
+            switch (c) {
+                case '"' -> builder.append("\\\"");
+                case '\\' -> builder.append("\\\\");
+                case '\n' -> builder.append("\\n");
+                case '\r' -> builder.append("\\r");
+                case '\t' -> builder.append("\\t");
+                default -> {
+                    if (c < 0x20) builder.append(String.format("\\u%04x", (int) c));
+                    else builder.append(c);
+                }
+            }
+        }
+        builder.append('"');
+    }
+
+    private Object value() {
+        whitespace();
+        if (current >= text.length()) throw error("Unexpected end of input");
+        char c = text.charAt(current);
+        return switch (c) {
+            case '{' -> object();
+            case '[' -> array();
+            case '"' -> string();
+            case 't' -> literal("true", true);
+            case 'f' -> literal("false", false);
+            case 'n' -> literal("null", null);
+            default -> number();
+        };
+    }
+
+    private Map<String, Object> object() {
+        Map<String, Object> object = new LinkedHashMap<>();
+        current++;
+        whitespace();
+        if (peek() == '}') {
+            current++;
+            return object;
+        }
+        while (true) {
+            whitespace();
+            if (peek() != '"') throw error("Expected a string key");
+            String key = string();
+            whitespace();
+            expect(':');
+            object.put(key, value());
+            whitespace();
+            if (peek() == ',') {
+                current++;
+                continue;
+            }
+            expect('}');
+            return object;
+        }
+    }
+
+    private List<Object> array() {
+        List<Object> array = new ArrayList<>();
+        current++;
+        whitespace();
+        if (peek() == ']') {
+            current++;
+            return array;
+        }
+        while (true) {
+            array.add(value());
+            whitespace();
+            if (peek() == ',') {
+                current++;
+                continue;
+            }
+            expect(']');
+            return array;
+        }
+    }
+
+    private String string() {
+        current++;
+        StringBuilder builder = new StringBuilder();
+        while (true) {
+            if (current >= text.length()) throw error("Unterminated string");
+            char c = text.charAt(current++);
+            if (c == '"') return builder.toString();
+            if (c != '\\') {
+                builder.append(c);
+                continue;
+            }
+            if (current >= text.length()) throw error("Unterminated string");
+            char escaped = text.charAt(current++);
+            switch (escaped) {
+                case 'b' -> builder.append('\b');
+                case 'f' -> builder.append('\f');
+                case 'n' -> builder.append('\n');
+                case 'r' -> builder.append('\r');
+                case 't' -> builder.append('\t');
+                case 'u' -> {
+                    if (current + 4 > text.length()) throw error("Bad unicode escape");
+                    builder.append((char) Integer.parseInt(text.substring(current, current + 4), 16));
+                    current += 4;
+                }
+                default -> builder.append(escaped);
+            }
+        }
+    }
+
+    private Object literal(String word, Object value) {
+        if (!text.startsWith(word, current)) throw error("Unexpected character");
+        current += word.length();
+        return value;
+    }
+
+    private Double number() {
+        int start = current;
+        while (current < text.length() && "+-0123456789.eE".indexOf(text.charAt(current)) >= 0) current++;
+        if (start == current) throw error("Unexpected character");
+        return Double.parseDouble(text.substring(start, current));
+    }
+
+    private void whitespace() {
+        while (current < text.length() && Character.isWhitespace(text.charAt(current))) current++;
+    }
+
+    private char peek() {
+        return current < text.length() ? text.charAt(current) : '\0';
+    }
+
+    private void expect(char c) {
+        if (peek() != c) throw error("Expected '" + c + "'");
+        current++;
+    }
+
+    private IllegalArgumentException error(String message) {
+        return new IllegalArgumentException(message + " at " + current + ".");
+    }
+}
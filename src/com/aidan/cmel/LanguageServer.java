@@ -0,0 +1,209 @@
+package com.aidan.cmel;
+
+import java.io.BufferedInputStream;
+import java.io.ByteArrayOutputStream;
+import java.io.IOException;
+import java.io.InputStream;
+import java.io.OutputStream;
+import java.nio.charset.StandardCharsets;
+import java.util.ArrayList;
+import java.util.HashMap;
+import java.util.LinkedHashMap;
+import java.util.List;
+import java.util.Map;
+
+// A language server speaking LSP over standard input and output, with
+// diagnostics, go to definition and hover. Documents are synchronised
+// incrementally, and a ServerDocument re-checks only the declarations an edit
+// touches.
+final class LanguageServer {
+    private final InputStream in;
+    private final OutputStream out;
+    private final Map<String, ServerDocument> documents = new HashMap<>();
+    // The natives every document's globals start from.
+    private final Interpreter base = new Interpreter("lsp");
+    private boolean shutdown = false;
+
+    private LanguageServer(InputStream in, OutputStream out) {
+        this.in = new BufferedInputStream(in);
+        this.out = out;
+    }
+
+    // Serves until the client sends exit, and answers the exit code it asks for.
+    static int serve(InputStream in, OutputStream out) throws IOException {
+        LanguageServer server = new LanguageServer(in, out);
+        while (true) {
+            String message = server.read();
+            if (message == null) return 1;
+
+            // A bad message is answered, or dropped if it's a notification,
+            // rather than taking the server down.
+            Map<String, Object> request;
+            try {
+                @SuppressWarnings("unchecked")
+                Map<String, Object> parsed = (Map<String, Object>) Json.parse(message);
+                request = parsed;
+            } catch (RuntimeException e) {
+                server.fail(null, -32700, "Parse error: " + e.getMessage());
+                continue;
+            }
+            if ("exit".equals(request.get("method"))) return server.shutdown ? 0 : 1;
+            try {
+                server.handle(request);
+            } catch (RuntimeException e) {
+                Object id = request.get("id");
+                if (id != null) server.fail(id, -32603, "Internal error: " + e);
+            }
+        }
+    }
+
+    @SuppressWarnings("unchecked")
+    private void handle(Map<String, Object> request) throws IOException {
+        String method = (String) request.get("method");
+        Object id = request.get("id");
+        Map<String, Object> params = (Map<String, Object>) request.get("params");
+        if (method == null) return;
+
+        switch (method) {
+            case "initialize" -> respond(id, Map.of(
+                    "capabilities", Map.of(
+                            "textDocumentSync", Map.of("openClose", true, "change", 2),
+                            "definitionProvider", true,
+                            "hoverProvider", true),
+                    "serverInfo", Map.of("name", "cmel")));
+            case "shutdown" -> {
+                shutdown = true;
+                respond(id, null);
+            }
+            case "textDocument/didOpen" -> {
+                Map<String, Object> document = (Map<String, Object>) params.get("textDocument");
+                String uri = (String) document.get("uri");
+                documents.put(uri, new ServerDocument((String) document.get("text"), base));
+                publish(uri);
+            }
+            case "textDocument/didChange" -> {
+                String uri = uri(params);
+                ServerDocument document = documents.get(uri);
+                if (document == null) return;
+                for (Object change : (List<Object>) params.get("contentChanges")) {
+                    Map<String, Object> edit = (Map<String, Object>) change;
+                    Map<String, Object> range = (Map<String, Object>) edit.get("range");
+                    if (range == null) {
+                        document.replace((String) edit.get("text"));
+                    } else {
+                        Map<String, Object> start = (Map<String, Object>) range.get("start");
+                        Map<String, Object> end = (Map<String, Object>) range.get("end");
+                        document.edit(integer(start, "line"), integer(start, "character"),
+                                integer(end, "line"), integer(end, "character"), (String) edit.get("text"));
+                    }
+                }
+                publish(uri);
+            }
+            case "textDocument/didClose" -> {
+                String uri = uri(params);
+                documents.remove(uri);
+                notify("textDocument/publishDiagnostics", Map.of("uri", uri, "diagnostics", List.of()));
+            }
+            case "textDocument/definition" -> {
+                ServerDocument document = documents.get(uri(params));
+                Map<String, Object> position = (Map<String, Object>) params.get("position");
+                ServerDocument.Span span = document == null ? null
+                        : document.definition(integer(position, "line"), integer(position, "character"));
+                respond(id, span == null ? null : Map.of("uri", uri(params), "range", range(span)));
+            }
+            case "textDocument/hover" -> {
+                ServerDocument document = documents.get(uri(params));
+                Map<String, Object> position = (Map<String, Object>) params.get("position");
+                String hover = document == null ? null
+                        : document.hover(integer(position, "line"), integer(position, "character"));
+                respond(id, hover == null ? null : Map.of("contents", Map.of("kind", "markdown", "value", hover)));
+            }
+            default -> {
+                // Notifications we don't handle are ignored; requests get an error.
+                if (id != null) fail(id, -32601, "Method not found: " + method);
+            }
+        }
+    }
+
+    private void publish(String uri) throws IOException {
+        List<Object> diagnostics = new ArrayList<>();
+        for (ServerDocument.Diagnostic diagnostic : documents.get(uri).diagnostics())
+            diagnostics.add(Map.of("range", range(diagnostic.span), "severity", 1, "source", "cmel", "message", diagnostic.message));
+        notify("textDocument/publishDiagnostics", Map.of("uri", uri, "diagnostics", diagnostics));
+    }
+
+    @SuppressWarnings("unchecked")
+    private static String uri(Map<String, Object> params) {
+        return (String) ((Map<String, Object>) params.get("textDocument")).get("uri");
+    }
+
+    private static int integer(Map<String, Object> object, String key) {
+        return ((Double) object.get(key)).intValue();
+    }
+
+    private static Map<String, Object> range(ServerDocument.Span span) {
+        return Map.of(
+                "start", Map.of("line", span.line, "character", span.start),
+                "end", Map.of("line", span.line, "character", span.end));
+    }
+
+    private void respond(Object id, Object result) throws IOException {
+        // Map.of doesn't allow the null a result may be.
+        Map<String, Object> response = new LinkedHashMap<>();
+        response.put("jsonrpc", "2.0");
+        response.put("id", id);
+        response.put("result", result);
+        write(response);
+    }
+
+    private void fail(Object id, int code, String message) throws IOException {
+        Map<String, Object> response = new LinkedHashMap<>();
+        response.put("jsonrpc", "2.0");
+        response.put("id", id);
+        response.put("error", Map.of("code", code, "message", message));
+        write(response);
+    }
+
+    private void notify(String method, Object params) throws IOException {
+        Map<String, Object> notification = new LinkedHashMap<>();
+        notification.put("jsonrpc", "2.0");
+        notification.put("method", method);
+        notification.put("params", params);
+        write(notification);
+    }
+
+    private void write(Object message) throws IOException {
+        byte[] body = Json.write(message).getBytes(StandardCharsets.UTF_8);
+        out.write(("Content-Length: " + body.length + "\r\n\r\n").getBytes(StandardCharsets.US_ASCII));
+        out.write(body);
+        out.flush();
+    }
+
+    // The next message's body, or null at the end of the input.
+    private String read() throws IOException {
+        int length = -1;
+        while (true) {
+            String header = readLine();
+            if (header == null) return null;
+            if (header.isEmpty()) break;
+            if (header.regionMatches(true, 0, "Content-Length:", 0, 15))
+                length = Integer.parseInt(header.substring(15).trim());
+        }
+        if (length < 0) throw new IOException("Message without a Content-Length.");
+
+        byte[] body = in.readNBytes(length);
+        if (body.length < length) return null;
+        return new String(body, StandardCharsets.UTF_8);
+    }
+
+    private String readLine() throws IOException {
+        ByteArrayOutputStream line = new ByteArrayOutputStream();
+        while (true) {
+            int b = in.read();
+            if (b < 0) return line.size() == 0 ? null : line.toString(StandardCharsets.US_ASCII);
+            if (b == '\n') break;
+            if (b != '\r') line.write(b);
+        }
+        return line.toString(StandardCharsets.US_ASCII);
+    }
+}
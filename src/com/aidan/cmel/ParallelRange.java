@@ -0,0 +1,83 @@
+package com.aidan.cmel;
+
+import java.util.SplittableRandom;
+import java.util.concurrent.ForkJoinPool;
+import java.util.concurrent.RecursiveAction;
+
+// Splits the iterations of a parallel for in half until each piece is small
+// enough to run serially, giving every piece its own worker interpreter.
+//
+// Iterations are grouped into blocks of BLOCK, and each block draws from its
+// own generator. The generators come from splitting the loop's down a binary
+// tree over the block indices, always halving at the midpoint, so which
+// numbers an iteration sees depends only on its index: not on the number of
+// threads, where the pieces were cut, or whether the loop ran in parallel.
+final class ParallelRange extends RecursiveAction {
+    private static final long BLOCK = 16;
+    // Pieces per worker thread, so that uneven iterations still balance out.
+    private static final int PIECES_PER_THREAD = 8;
+
+    private final Interpreter parent;
+    private final Statement.ParallelFor loop;
+    private final double first;
+    private final long count;
+    // Blocks, not iterations.
+    private final long lo;
+    private final long hi;
+    private final long grain;
+    private final SplittableRandom random;
+
+    ParallelRange(Interpreter parent, Statement.ParallelFor loop, double first, long count, SplittableRandom random) {
+        this(parent, loop, first, count, 0, blocks(count),
+                Math.max(1, blocks(count) / ((long) ForkJoinPool.getCommonPoolParallelism() * PIECES_PER_THREAD)), random);
+    }
+
+    private ParallelRange(Interpreter parent, Statement.ParallelFor loop, double first, long count, long lo, long hi,
+                          long grain, SplittableRandom random) {
+        this.parent = parent;
+        this.loop = loop;
+        this.first = first;
+        this.count = count;
+        this.lo = lo;
+        this.hi = hi;
+        this.grain = grain;
+        this.random = random;
+    }
+
+    @Override
+    protected void compute() {
+        if (hi - lo <= grain) {
+            runBlocks(parent.fork(random), loop, first, count, lo, hi, random);
+            return;
+        }
+
+        long mid = lo + (hi - lo) / 2;
+        SplittableRandom right = random.split();
+        invokeAll(new ParallelRange(parent, loop, first, count, lo, mid, grain, random),
+                new ParallelRange(parent, loop, first, count, mid, hi, grain, right));
+    }
+
+    // Runs all count iterations on interpreter, one block after another, with
+    // the generators a parallel run would have given them.
+    static void runSerially(Interpreter interpreter, Statement.ParallelFor loop, double first, long count,
+                            SplittableRandom random) {
+        runBlocks(interpreter, loop, first, count, 0, blocks(count), random);
+    }
+
+    private static void runBlocks(Interpreter interpreter, Statement.ParallelFor loop, double first, long count,
+                                  long lo, long hi, SplittableRandom random) {
+        if (hi - lo == 1) {
+            interpreter.runIterations(loop, first, lo * BLOCK, Math.min(hi * BLOCK, count), random);
+            return;
+        }
+
+        long mid = lo + (hi - lo) / 2;
+        SplittableRandom right = random.split();
+        runBlocks(interpreter, loop, first, count, lo, mid, random);
+        runBlocks(interpreter, loop, first, count, mid, hi, right);
+    }
+
+    private static long blocks(long count) {
+        return (count + BLOCK - 1) / BLOCK;
+    }
+}
@@ -0,0 +1,111 @@
+package com.aidan.cmel;
+
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.List;
+import java.util.concurrent.ForkJoinPool;
+import java.util.concurrent.ForkJoinTask;
+
+// Scans a large source on several threads. A quick pass over the characters,
+// which tracks only whether it is inside a string, an interpolated expression
+// or a comment, finds newlines at which a Scanner would be in its initial
+// state, and the line each starts. The chunks between them are scanned
+// concurrently and their tokens joined, giving the same tokens, and errors in
+// the same order, as one Scanner over the whole source.
+final class ParallelScanner {
+    // Below this many characters per chunk, splitting costs more than it saves.
+    private static final int MIN_CHUNK = 1 << 16;
+
+    private ParallelScanner() {}
+
+    static boolean worthSplitting(String source) {
+        return ForkJoinPool.commonPool().getParallelism() > 1 && source.length() >= 2 * MIN_CHUNK;
+    }
+
+    static List<Token> scanTokens(String source) {
+        if (!worthSplitting(source)) return new Scanner(source).scanTokens();
+        int target = Math.max(MIN_CHUNK, source.length() / (ForkJoinPool.commonPool().getParallelism() * 4));
+
+        List<int[]> chunks = split(source, target);
+        Scanner[] scanners = new Scanner[chunks.size()];
+        List<ForkJoinTask<List<Token>>> tasks = new ArrayList<>(chunks.size());
+        for (int i = 0; i < scanners.length; i++) {
+            int[] chunk = chunks.get(i);
+            Scanner scanner = scanners[i] = new Scanner(source, chunk[0], chunk[1], chunk[2]);
+            boolean last = i == scanners.length - 1;
+            tasks.add(ForkJoinPool.commonPool().submit(() -> last ? scanner.scanTokens() : scanner.scanChunk()));
+        }
+
+        List<Token> tokens = new ArrayList<>();
+        for (int i = 0; i < scanners.length; i++) {
+            tokens.addAll(tasks.get(i).join());
+            scanners[i].reportErrors();
+        }
+        return tokens;
+    }
+
+    // Chunks as {from, to, line}, each ending just after a newline that is
+    // outside any string, at least target characters after the last.
+    private static List<int[]> split(String source, int target) {
+        List<int[]> chunks = new ArrayList<>();
+        // Brace depth inside each interpolated expression being scanned.
+        int[] interpolations = new int[16];
+        int depth = 0;
+        boolean inString = false;
+        int from = 0;
+        int line = 1;
+        int fromLine = 1;
+
+        int length = source.length();
+        for (int i = 0; i < length; i++) {
+            char c = source.charAt(i);
+            if (c == '\n') line++;
+
+            if (inString) {
+                if (c == '"') {
+                    inString = false;
+                } else if (c == '$' && i + 1 < length && source.charAt(i + 1) == '{') {
+                    if (depth == interpolations.length)
+                        interpolations = Arrays.copyOf(interpolations, depth * 2);
+                    interpolations[depth++] = 0;
+                    inString = false;
+                    i++;
+                }
+                continue;
+            }
+
+            switch (c) {
+                case '"' -> inString = true;
+                case '/' -> {
+                    if (i + 1 < length && source.charAt(i + 1) == '/') {
+                        // The newline ending the comment is left for the next
+                        // iteration, as the Scanner leaves it for the next token.
+                        while (i + 1 < length && source.charAt(i + 1) != '\n') i++;
+                    }
+                }
+                case '{' -> {
+                    if (depth > 0) interpolations[depth - 1]++;
+                }
+                case '}' -> {
+                    if (depth > 0 && interpolations[depth - 1] == 0) {
+                        depth--;
+                        inString = true;
+                    } else if (depth > 0) {
+                        interpolations[depth - 1]--;
+                    }
+                }
+                case '\n' -> {
+                    if (depth == 0 && i + 1 - from >= target && length - (i + 1) >= target / 2) {
+                        chunks.add(new int[] {from, i + 1, fromLine});
+                        from = i + 1;
+                        fromLine = line;
+                    }
+                }
+                default -> {}
+            }
+        }
+
+        chunks.add(new int[] {from, length, fromLine});
+        return chunks;
+    }
+}
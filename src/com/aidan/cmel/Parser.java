@@ -9,21 +9,50 @@ public class Parser {
 
     private static class ParseError extends RuntimeException {}
     private final List<Token> tokens;
+    private final Scanner scanner;
+    private final Resolver resolver;
     private int current = 0;
+    private boolean hadError = false;
 
     public Parser(List<Token> tokens) {
+        this(tokens, false, null);
+    }
+
+    // For tokens scanned up front; when scanning them reported errors,
+    // nothing is resolved.
+    public Parser(List<Token> tokens, boolean hadScanError, Resolver resolver) {
         this.tokens = tokens;
+        this.scanner = null;
+        this.resolver = resolver;
+        this.hadError = hadScanError;
+    }
+
+    // Single pass front end: tokens are pulled from the scanner on demand and
+    // each top-level declaration is resolved as soon as it has been parsed.
+    public Parser(Scanner scanner, Resolver resolver) {
+        this.tokens = new ArrayList<>();
+        this.scanner = scanner;
+        this.resolver = resolver;
     }
 
     public List<Statement> parse() {
         List<Statement> statements = new ArrayList<>();
         while (!isAtEnd()) {
-            statements.add(declaration());
+            Statement statement = declaration();
+            statements.add(statement);
+
+            if (resolver != null && !hadError && (scanner == null || !scanner.hadError()))
+                resolver.resolve(statement);
         }
 
         return statements;
     }
 
+    // Whether scanning, parsing or resolving has reported an error so far.
+    public boolean hadError() {
+        return hadError || (scanner != null && scanner.hadError()) || (resolver != null && resolver.hadError());
+    }
+
     private Statement declaration() {
         try {
             if (match(CLASS)) return classDeclaration();
@@ -81,6 +110,8 @@ public class Parser {
 
     private Statement statement() {
         if (match(FOR)) return forStatement();
+        if (match(PARALLEL)) return parallelForStatement();
+        if (match(ATOMIC)) return atomicStatement();
         if (match(IF)) return ifStatement();
         if (match(RETURN)) return returnStatement();
         if (match(WHILE)) return whileStatement();
@@ -129,6 +160,49 @@ public class Parser {
         return body;
     }
 
+    private Statement atomicStatement() {
+        Token keyword = previous();
+        consume(LEFT_BRACE, "Expect '{' after 'atomic'.");
+        return new Statement.Atomic(keyword, new Statement.Block(block()));
+    }
+
+    // Only counted loops of the form (var i = start; i < end; i = i + 1) can be
+    // split across threads, so that is the only form accepted here.
+    private Statement parallelForStatement() {
+        Token keyword = previous();
+        consume(FOR, "Expect 'for' after 'parallel'.");
+        consume(LEFT_PAREN, "Expect '(' after for.");
+
+        consume(VAR, "Expect loop variable declaration in parallel for.");
+        Token variable = consume(IDENTIFIER, "Expect variable name.");
+        consume(EQUAL, "Expect '=' after loop variable.");
+        Expression start = expression();
+        consume(SEMICOLON, "Expect ';' after loop initializer.");
+
+        consumeLoopVariable(variable);
+        consume(LESS, "Expect '<' in parallel for condition.");
+        Expression end = expression();
+        consume(SEMICOLON, "Expected ';' after loop condition.");
+
+        consumeLoopVariable(variable);
+        consume(EQUAL, "Expect parallel for increment to assign the loop variable.");
+        consumeLoopVariable(variable);
+        consume(PLUS, "Expect parallel for to step by 1.");
+        Token step = consume(NUMBER, "Expect parallel for to step by 1.");
+        if (!step.getLiteral().equals(1.0))
+            throw error(step, "Expect parallel for to step by 1.");
+        consume(RIGHT_PAREN, "Expect ')' after for clauses.");
+
+        Statement body = statement();
+        return new Statement.ParallelFor(keyword, variable, start, end, body);
+    }
+
+    private void consumeLoopVariable(Token variable) {
+        Token name = consume(IDENTIFIER, "Expect loop variable '" + variable.getLexeme() + "'.");
+        if (!name.getLexeme().equals(variable.getLexeme()))
+            throw error(name, "Expect loop variable '" + variable.getLexeme() + "'.");
+    }
+
     private Statement ifStatement() {
         consume(LEFT_PAREN, "Expect '(' after if.");
         Expression condition = expression();
@@ -190,10 +264,17 @@ public class Parser {
             Expression value = assignment();
 
             if (expression instanceof Expression.Variable expr) {
+                Expression increment = increment(expr, value);
+                if (increment != null) return increment;
+
                 Token name = expr.name;
                 return new Expression.Assign(name, value);
             } else if (expression instanceof Expression.Get expr) {
                 return new Expression.Set(expr.object, expr.name, value);
+            } else if (expression instanceof Expression.GetThisField expr) {
+                return new Expression.Set(expr.object, expr.name, value);
+            } else if (expression instanceof Expression.Index expr) {
+                return new Expression.IndexSet(expr.object, expr.bracket, expr.index, value);
             }
 
             error(equals, "Invalid assignment target.");
@@ -264,7 +345,11 @@ public class Parser {
         while (match(LESS, LESS_EQUAL, GREATER, GREATER_EQUAL)) {
             Token operator = previous();
             Expression right = term();
-            expression = new Expression.Binary(expression, operator, right);
+            if (operator.getType() == LESS && expression instanceof Expression.Variable variable
+                    && right instanceof Expression.Literal literal && literal.value instanceof Double constant)
+                expression = new Expression.LessThanConstant(variable, operator, constant);
+            else
+                expression = new Expression.Binary(expression, operator, right);
         }
 
         return expression;
@@ -301,9 +386,23 @@ public class Parser {
             return new Expression.Unary(operator, right);
         }
 
+        if (match(COMPTIME)) return comptime();
+
         return call();
     }
 
+    // x = x + n and x = x - n, fused into one node.
+    private Expression increment(Expression.Variable target, Expression value) {
+        if (value instanceof Expression.Binary binary
+                && (binary.operator.getType() == PLUS || binary.operator.getType() == MINUS)
+                && binary.left instanceof Expression.Variable variable
+                && variable.name.getLexeme().equals(target.name.getLexeme())
+                && binary.right instanceof Expression.Literal literal
+                && literal.value instanceof Double amount)
+            return new Expression.IncrementBy(variable, binary.operator, amount);
+        return null;
+    }
+
     private Expression call() {
         if (match(FUN)) return anonFunction();
 
@@ -314,7 +413,14 @@ public class Parser {
                 expression = finishCall(expression);
             } else if (match(DOT)) {
                 Token name = consume(IDENTIFIER, "Expect property name after '.'.");
-                expression = new Expression.Get(expression, name);
+                if (expression instanceof Expression.This self)
+                    expression = new Expression.GetThisField(self, name);
+                else
+                    expression = new Expression.Get(expression, name);
+            } else if (match(LEFT_BRACKET)) {
+                Expression index = expression();
+                Token bracket = consume(RIGHT_BRACKET, "Expect ']' after index.");
+                expression = new Expression.Index(expression, bracket, index);
             } else{
                 break;
             }
@@ -323,6 +429,19 @@ public class Parser {
         return expression;
     }
 
+    private Expression comptime() {
+        Token keyword = previous();
+
+        // A comptime block is sugar for an immediately called anonymous function.
+        if (match(LEFT_BRACE)) {
+            List<Statement> body = block();
+            Expression function = new Expression.AnonFunction(new ArrayList<>(), body);
+            return new Expression.Comptime(keyword, new Expression.Call(function, keyword, new ArrayList<>()));
+        }
+
+        return new Expression.Comptime(keyword, unary());
+    }
+
     private Expression anonFunction() {
         consume(LEFT_PAREN, "Expect '(' after fun.");
 
@@ -354,9 +473,33 @@ public class Parser {
         }
 
         Token paren = consume(RIGHT_PAREN, "Expect ')' after arguments.");
+        if (callee instanceof Expression.Variable variable)
+            return new Expression.CallVariable(variable, paren, arguments);
         return new Expression.Call(callee, paren, arguments);
     }
 
+    // "a ${x} b ${y} c" arrives as INTERPOLATION("a ") x INTERPOLATION(" b ") y STRING(" c").
+    private Expression interpolation() {
+        Token quote = previous();
+        List<String> strings = new ArrayList<>();
+        List<Expression> values = new ArrayList<>();
+        strings.add((String) quote.getLiteral());
+
+        while (true) {
+            values.add(expression());
+            if (match(INTERPOLATION)) {
+                strings.add((String) previous().getLiteral());
+                continue;
+            }
+            strings.add((String) consume(STRING, "Expect '}' after interpolated expression.").getLiteral());
+            break;
+        }
+
+        int literalLength = 0;
+        for (String string : strings) literalLength += string.length();
+        return new Expression.Interpolation(quote, strings, values, literalLength);
+    }
+
     private Expression primary() {
         if (match(TRUE)) return new Expression.Literal(true);
         if (match(FALSE)) return new Expression.Literal(false);
@@ -365,6 +508,8 @@ public class Parser {
         if (match(NUMBER, STRING))
             return new Expression.Literal(previous().getLiteral());
 
+        if (match(INTERPOLATION)) return interpolation();
+
         if (match(THIS))
             return new Expression.This(previous());
 
@@ -386,6 +531,7 @@ public class Parser {
     }
 
     private ParseError error(Token token, String message) {
+        hadError = true;
         Cmel.error(token, message);
         return new ParseError();
     }
@@ -397,7 +543,7 @@ public class Parser {
             if (previous().getType() == SEMICOLON) return;
 
             switch (peek().getType()) {
-                case CLASS, FUN, VAR, FOR, IF, WHILE, RETURN -> {
+                case CLASS, FUN, VAR, FOR, PARALLEL, ATOMIC, IF, WHILE, RETURN -> {
                     return;
                 }
             }
@@ -431,6 +577,8 @@ public class Parser {
     }
 
     private Token peek() {
+        while (current >= tokens.size())
+            tokens.add(scanner.nextToken());
         return tokens.get(current);
     }
 
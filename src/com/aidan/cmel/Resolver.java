@@ -1,8 +1,12 @@
 package com.aidan.cmel;
 
+import java.util.ArrayList;
 import java.util.HashMap;
+import java.util.HashSet;
+import java.util.LinkedHashMap;
 import java.util.List;
 import java.util.Map;
+import java.util.Set;
 import java.util.Stack;
 
 public class Resolver implements Expression.Visitor<Void>, Statement.Visitor<Void> {
@@ -21,14 +25,86 @@ public class Resolver implements Expression.Visitor<Void>, Statement.Visitor<Voi
     private final Stack<Map<String, Boolean>> scopes;
     private FunctionType currentFunction = FunctionType.NONE;
 
+    // Index of the innermost scope opened inside a comptime expression, or -1.
+    // Anything declared in an enclosing scope only exists at run time.
+    private int comptimeScope = -1;
+
+    // Index of the scope opened by the innermost atomic block, or -1. Only
+    // field writes are isolated by a transaction, so variables from outside
+    // the block can't be assigned inside it.
+    private int atomicScope = -1;
+
+    // For each function being resolved, the index of its parameter scope and
+    // the node itself when it is anonymous (null for named functions).
+    private final Stack<Integer> functionScopes = new Stack<>();
+    private final Stack<Expression.AnonFunction> anonFunctions = new Stack<>();
+
+    // Locals declared as var p = SomeClass(...), by scope alongside scopes,
+    // with every p.field and p.field = value seen so far. One that is used
+    // any other way escapes; the rest are scalar replaced when their scope
+    // ends.
+    private final Stack<Map<String, Candidate>> candidates = new Stack<>();
+
+    private static final class Candidate {
+        final Statement.Var declaration;
+        final int function;
+        final List<Expression.Get> gets = new ArrayList<>();
+        final List<Expression.Set> sets = new ArrayList<>();
+        boolean escapes = false;
+
+        Candidate(Statement.Var declaration, int function) {
+            this.declaration = declaration;
+            this.function = function;
+        }
+    }
+
+    // Locals declared with a number literal, by scope alongside scopes, with
+    // every read and assignment of them. Those that get assigned, which are
+    // loop counters and accumulators, are given number slots when their scope
+    // ends.
+    private final Stack<Map<String, NumberLocal>> numberLocals = new Stack<>();
+
+    private static final class NumberLocal {
+        final Statement.Var declaration;
+        final List<Expression> uses = new ArrayList<>();
+        boolean assigned = false;
+
+        NumberLocal(Statement.Var declaration) {
+            this.declaration = declaration;
+        }
+    }
+
+    // For a language server, told the token declaring each name looked up, or
+    // null for a global, and that each local declaration declares itself;
+    // null otherwise. The tokens declaring each scope's
+    // names are kept alongside scopes only when it is set, and comptime
+    // expressions are then checked but never run, so an editor can't hang on
+    // or be written to by the code it is checking.
+    interface References {
+        void reference(Token name, Token declaration);
+    }
+
+    private final References references;
+    private final Stack<Map<String, Token>> declarations = new Stack<>();
+
+    private boolean hadError = false;
+
     public Resolver(Interpreter interpreter) {
+        this(interpreter, null);
+    }
+
+    Resolver(Interpreter interpreter, References references) {
         this.interpreter = interpreter;
+        this.references = references;
         scopes = new Stack<>();
     }
 
     @Override
     public Void visitAssignExpression(Expression.Assign expression) {
         resolve(expression.value);
+        escape(expression.name);
+        if (atomicScope >= 0 && scopeOf(expression.name) < atomicScope)
+            error(expression.name, "Can't assign to a variable declared outside an atomic block.");
         resolveLocal(expression, expression.name);
         return null;
     }
@@ -58,7 +134,71 @@ public class Resolver implements Expression.Visitor<Void>, Statement.Visitor<Voi
     @Override
     public Void visitSetExpression(Expression.Set expression) {
         resolve(expression.value);
+
+        // A write inside an atomic block has to go to a real instance to be
+        // part of the transaction.
+        Candidate candidate = candidate(expression.object);
+        if (candidate != null && candidate.function == functionScopes.size()
+                && (atomicScope < 0 || scopeOf(candidate.declaration.name) >= atomicScope)) {
+            candidate.sets.add(expression);
+            resolveLocal(expression.object, ((Expression.Variable) expression.object).name);
+            return null;
+        }
+
+        resolve(expression.object);
+        return null;
+    }
+
+    @Override
+    public Void visitIndexExpression(Expression.Index expression) {
+        resolve(expression.object);
+        resolve(expression.index);
+        return null;
+    }
+
+    @Override
+    public Void visitIndexSetExpression(Expression.IndexSet expression) {
+        resolve(expression.value);
         resolve(expression.object);
+        resolve(expression.index);
+        return null;
+    }
+
+    @Override
+    public Void visitInterpolationExpression(Expression.Interpolation expression) {
+        for (Expression value : expression.values)
+            resolve(value);
+        return null;
+    }
+
+    @Override
+    public Void visitLessThanConstantExpression(Expression.LessThanConstant expression) {
+        resolve(expression.variable);
+        return null;
+    }
+
+    @Override
+    public Void visitIncrementByExpression(Expression.IncrementBy expression) {
+        if (atomicScope >= 0 && scopeOf(expression.variable.name) < atomicScope)
+            error(expression.variable.name, "Can't assign to a variable declared outside an atomic block.");
+        resolve(expression.variable);
+        NumberLocal local = numberLocal(expression.variable.name);
+        if (local != null) local.assigned = true;
+        return null;
+    }
+
+    @Override
+    public Void visitGetThisFieldExpression(Expression.GetThisField expression) {
+        resolve(expression.object);
+        return null;
+    }
+
+    @Override
+    public Void visitCallVariableExpression(Expression.CallVariable expression) {
+        resolve(expression.callee);
+
+        for (Expression arg : expression.arguments)
+            resolve(arg);
         return null;
     }
 
@@ -91,19 +231,99 @@ public class Resolver implements Expression.Visitor<Void>, Statement.Visitor<Voi
     @Override
     public Void visitVariableExpression(Expression.Variable expression) {
         if (!scopes.isEmpty() && scopes.peek().get(expression.name.getLexeme()) == Boolean.FALSE)
-            Cmel.error(expression.name, "Can't read local variable in it's own initializer;");
+            error(expression.name, "Can't read local variable in it's own initializer;");
 
         resolveLocal(expression, expression.name);
+        escape(expression.name);
         return null;
     }
 
+    private Candidate candidate(Expression expression) {
+        if (!(expression instanceof Expression.Variable variable)) return null;
+        int scope = scopeOf(variable.name);
+        if (scope < 0) return null;
+        return candidates.get(scope).get(variable.name.getLexeme());
+    }
+
+    private void escape(Token name) {
+        int scope = scopeOf(name);
+        if (scope < 0) return;
+        Candidate candidate = candidates.get(scope).get(name.getLexeme());
+        if (candidate != null) candidate.escapes = true;
+    }
+
+    private NumberLocal numberLocal(Token name) {
+        int scope = scopeOf(name);
+        if (scope < 0) return null;
+        return numberLocals.get(scope).get(name.getLexeme());
+    }
+
+    private void assignNumberSlots(Map<String, NumberLocal> scope) {
+        int slot = 0;
+        for (NumberLocal local : scope.values()) {
+            if (!local.assigned) continue;
+            local.declaration.numberSlot = ++slot;
+            for (Expression use : local.uses) {
+                if (use instanceof Expression.Variable variable) variable.numberSlot = slot;
+                else ((Expression.Assign) use).numberSlot = slot;
+            }
+        }
+    }
+
+    private void replaceScalars(Map<String, Candidate> scope) {
+        for (Candidate candidate : scope.values()) {
+            if (candidate.escapes || (candidate.gets.isEmpty() && candidate.sets.isEmpty())) continue;
+
+            Token variable = candidate.declaration.name;
+            Map<String, Token> slots = new LinkedHashMap<>();
+            Set<String> reads = new HashSet<>();
+            for (Expression.Get get : candidate.gets) {
+                get.slot = slots.computeIfAbsent(get.name.getLexeme(), field -> ScalarReplacement.slot(variable, field));
+                reads.add(get.name.getLexeme());
+            }
+            for (Expression.Set set : candidate.sets)
+                set.slot = slots.computeIfAbsent(set.name.getLexeme(), field -> ScalarReplacement.slot(variable, field));
+            candidate.declaration.scalar = new ScalarReplacement(slots, reads);
+        }
+    }
+
     private void resolveLocal(Expression expression, Token name) {
         for (int i = scopes.size() - 1; i >= 0; i--) {
             if (scopes.get(i).containsKey(name.getLexeme())) {
+                if (i < comptimeScope)
+                    error(name, "Can't use a local variable from outside a comptime expression.");
+
                 interpreter.resolve(expression, scopes.size() - 1 - i);
+                markCaptured(i);
+                if (references != null && declarations.get(i).containsKey(name.getLexeme()))
+                    references.reference(name, declarations.get(i).get(name.getLexeme()));
+
+                NumberLocal local = numberLocals.get(i).get(name.getLexeme());
+                if (local != null && (expression instanceof Expression.Variable || expression instanceof Expression.Assign)) {
+                    local.uses.add(expression);
+                    if (expression instanceof Expression.Assign) local.assigned = true;
+                }
                 return;
             }
         }
+        if (references != null) references.reference(name, null);
+    }
+
+    // Index of the scope declaring name, or -1 for a global.
+    private int scopeOf(Token name) {
+        for (int i = scopes.size() - 1; i >= 0; i--) {
+            if (scopes.get(i).containsKey(name.getLexeme())) return i;
+        }
+        return -1;
+    }
+
+    // Anonymous functions that read a local declared outside of themselves
+    // need their closure and so can't be hoisted.
+    private void markCaptured(int scope) {
+        for (int i = functionScopes.size() - 1; i >= 0 && functionScopes.get(i) > scope; i--) {
+            Expression.AnonFunction function = anonFunctions.get(i);
+            if (function != null) function.hoistable = false;
+        }
     }
 
     @Override
@@ -112,6 +332,17 @@ public class Resolver implements Expression.Visitor<Void>, Statement.Visitor<Voi
         return null;
     }
 
+    @Override
+    public Void visitComptimeExpression(Expression.Comptime expression) {
+        int enclosingComptime = comptimeScope;
+        comptimeScope = scopes.size();
+        resolve(expression.expression);
+        comptimeScope = enclosingComptime;
+
+        if (!hadError && references == null) interpreter.evaluateComptime(expression);
+        return null;
+    }
+
     @Override
     public Void visitBlockStatement(Statement.Block statement) {
         beginScope();
@@ -140,6 +371,7 @@ public class Resolver implements Expression.Visitor<Void>, Statement.Visitor<Voi
         }
 
         endScope();
+        if (scopes.isEmpty() && references == null) interpreter.declareForComptime(statement);
 
         currentClass = enclosingClass;
         return null;
@@ -147,6 +379,13 @@ public class Resolver implements Expression.Visitor<Void>, Statement.Visitor<Voi
 
     @Override
     public Void visitGetExpression(Expression.Get expression) {
+        Candidate candidate = candidate(expression.object);
+        if (candidate != null && candidate.function == functionScopes.size()) {
+            candidate.gets.add(expression);
+            resolveLocal(expression.object, ((Expression.Variable) expression.object).name);
+            return null;
+        }
+
         resolve(expression.object);
         return null;
     }
@@ -154,7 +393,7 @@ public class Resolver implements Expression.Visitor<Void>, Statement.Visitor<Voi
     @Override
     public Void visitThisExpression(Expression.This expression) {
         if (currentClass == ClassType.NONE) {
-            Cmel.error(expression.keyword, "Can't use 'this' outside of a class.");
+            error(expression.keyword, "Can't use 'this' outside of a class.");
             return null;
         }
 
@@ -164,10 +403,26 @@ public class Resolver implements Expression.Visitor<Void>, Statement.Visitor<Voi
 
     private void beginScope() {
         scopes.push(new HashMap<>());
+        candidates.push(new HashMap<>());
+        numberLocals.push(new LinkedHashMap<>());
+        if (references != null) declarations.push(new HashMap<>());
     }
 
     private void endScope() {
         scopes.pop();
+        replaceScalars(candidates.pop());
+        assignNumberSlots(numberLocals.pop());
+        if (references != null) declarations.pop();
+    }
+
+    // Whether any resolution error has been reported.
+    public boolean hadError() {
+        return hadError;
+    }
+
+    private void error(Token token, String message) {
+        hadError = true;
+        Cmel.error(token, message);
     }
 
     public void resolve(List<Statement> statements) {
@@ -175,7 +430,7 @@ public class Resolver implements Expression.Visitor<Void>, Statement.Visitor<Voi
             resolve(statement);
     }
 
-    private void resolve(Statement statement) {
+    void resolve(Statement statement) {
         statement.accept(this);
     }
 
@@ -204,6 +459,11 @@ public class Resolver implements Expression.Visitor<Void>, Statement.Visitor<Voi
             resolve(statement.initializer);
         define(statement.name);
 
+        if (!scopes.isEmpty() && statement.initializer instanceof Expression.CallVariable)
+            candidates.peek().put(statement.name.getLexeme(), new Candidate(statement, functionScopes.size()));
+        if (!scopes.isEmpty() && statement.initializer instanceof Expression.Literal literal && literal.value instanceof Double)
+            numberLocals.peek().put(statement.name.getLexeme(), new NumberLocal(statement));
+
         return null;
     }
 
@@ -211,8 +471,12 @@ public class Resolver implements Expression.Visitor<Void>, Statement.Visitor<Voi
         if (scopes.isEmpty()) return;
         Map<String, Boolean> scope = scopes.peek();
         if (scope.containsKey(name.getLexeme()))
-            Cmel.error(name, "There is already a variable with this name in scope.");
+            error(name, "There is already a variable with this name in scope.");
         scope.put(name.getLexeme(), false);
+        if (references != null) {
+            declarations.peek().put(name.getLexeme(), name);
+            references.reference(name, name);
+        }
     }
 
     private void define(Token name) {
@@ -227,18 +491,43 @@ public class Resolver implements Expression.Visitor<Void>, Statement.Visitor<Voi
         return null;
     }
 
+    @Override
+    public Void visitAtomicStatement(Statement.Atomic statement) {
+        int enclosingAtomic = atomicScope;
+        atomicScope = scopes.size();
+        resolve(statement.body);
+        atomicScope = enclosingAtomic;
+        return null;
+    }
+
+    @Override
+    public Void visitParallelForStatement(Statement.ParallelFor statement) {
+        resolve(statement.start);
+        resolve(statement.end);
+
+        beginScope();
+        declare(statement.variable);
+        define(statement.variable);
+        resolve(statement.body);
+        endScope();
+        return null;
+    }
+
     @Override
     public Void visitFunctionStatement(Statement.Function statement) {
         declare(statement.name);
         define(statement.name);
 
         resolveFunction(statement, FunctionType.FUNCTION);
+        if (scopes.isEmpty() && references == null) interpreter.declareForComptime(statement);
         return null;
     }
 
     private void resolveFunction(Statement.Function function, FunctionType type) {
         FunctionType enclosingFunction = currentFunction;
         currentFunction = type;
+        functionScopes.push(scopes.size());
+        anonFunctions.push(null);
 
         beginScope();
         for (Token param : function.parameters) {
@@ -247,12 +536,18 @@ public class Resolver implements Expression.Visitor<Void>, Statement.Visitor<Voi
         }
         resolve(function.body);
         endScope();
+
+        functionScopes.pop();
+        anonFunctions.pop();
         currentFunction = enclosingFunction;
     }
 
     private void resolveAnonFunction(Expression.AnonFunction function, FunctionType type) {
         FunctionType enclosingFunction = currentFunction;
         currentFunction = type;
+        function.hoistable = true;
+        functionScopes.push(scopes.size());
+        anonFunctions.push(function);
 
         beginScope();
         for (Token param : function.parameters) {
@@ -261,16 +556,19 @@ public class Resolver implements Expression.Visitor<Void>, Statement.Visitor<Voi
         }
         resolve(function.body);
         endScope();
+
+        functionScopes.pop();
+        anonFunctions.pop();
         currentFunction = enclosingFunction;
     }
 
     @Override
     public Void visitReturnStatement(Statement.Return statement) {
         if (currentFunction == FunctionType.NONE)
-            Cmel.error(statement.keyword, "Can't return outside of a function.");
+            error(statement.keyword, "Can't return outside of a function.");
         if (statement.value != null) {
             if (currentFunction == FunctionType.INITIALIZER) {
-                Cmel.error(statement.keyword, "Can't return a value from an initializer.");
+                error(statement.keyword, "Can't return a value from an initializer.");
             }
             resolve(statement.value);
         }
@@ -8,6 +8,10 @@ public class RuntimeError extends RuntimeException {
         this.token = token;
     }
 
+    public RuntimeError(String message) {
+        this(null, message);
+    }
+
     public Token getToken() {
         return token;
     }
@@ -0,0 +1,142 @@
+package com.aidan.cmel;
+
+import java.util.ArrayList;
+import java.util.LinkedHashMap;
+import java.util.List;
+import java.util.Map;
+import java.util.Set;
+
+// A local initialised by calling a named class, var p = Point(x, y), which the
+// resolver found is only ever used as p.field or p.field = value in the
+// function declaring it, so the instance can't escape. When the class turns
+// out at run time to have an initializer that only copies arguments and
+// constants into fields, and no field read shares a name with a method, no
+// instance, field map or bound initializer is made: each field lives in a
+// local of its own named "p.field", which no variable can clash with, and p
+// holds REPLACED so that p.field knows to look there. Otherwise the instance
+// is made as usual.
+final class ScalarReplacement {
+    static final Object REPLACED = new Object();
+    // What a field slot holds before anything is stored in it.
+    static final Object ABSENT = new Object();
+
+    // Where an initializer gets each field it sets: the argument at arguments[i],
+    // or constants[i] when that is -1.
+    private static final class Shape {
+        final CmelClass klass;
+        final int arity;
+        final String[] fields;
+        final int[] arguments;
+        final Object[] constants;
+
+        Shape(CmelClass klass, int arity, String[] fields, int[] arguments, Object[] constants) {
+            this.klass = klass;
+            this.arity = arity;
+            this.fields = fields;
+            this.arguments = arguments;
+            this.constants = constants;
+        }
+    }
+
+    private final Map<String, Token> slots;
+    private final Set<String> reads;
+
+    // The last class seen, whether it could be replaced or not; classes are
+    // almost always the same each time.
+    private volatile Shape shape;
+    private volatile CmelClass rejected;
+
+    ScalarReplacement(Map<String, Token> slots, Set<String> reads) {
+        this.slots = slots;
+        this.reads = reads;
+    }
+
+    static Token slot(Token variable, String field) {
+        return new Token(TokenType.IDENTIFIER, variable.getLexeme() + "." + field, null, variable.getLine());
+    }
+
+    Map<String, Token> slots() {
+        return slots;
+    }
+
+    Set<String> reads() {
+        return reads;
+    }
+
+    // Defines the variable and its field slots in the environment, or answers
+    // false, having evaluated nothing, when the instance has to be made after
+    // all.
+    boolean instantiate(Interpreter interpreter, Statement.Var statement, Environment environment) {
+        Expression.CallVariable call = (Expression.CallVariable) statement.initializer;
+        if (!(interpreter.visitVariableExpression(call.callee) instanceof CmelClass klass)) return false;
+        Shape shape = shapeOf(klass);
+        if (shape == null || shape.arity != call.arguments.size()) return false;
+
+        Object[] arguments = new Object[shape.arity];
+        for (int i = 0; i < arguments.length; i++)
+            arguments[i] = interpreter.evaluate(call.arguments.get(i));
+
+        environment.define(statement.name.getLexeme(), REPLACED);
+        for (Token slot : slots.values())
+            environment.define(slot.getLexeme(), ABSENT);
+        for (int i = 0; i < shape.fields.length; i++) {
+            Token slot = slots.get(shape.fields[i]);
+            if (slot != null)
+                environment.define(slot.getLexeme(), shape.arguments[i] >= 0 ? arguments[shape.arguments[i]] : shape.constants[i]);
+        }
+        return true;
+    }
+
+    private Shape shapeOf(CmelClass klass) {
+        Shape current = shape;
+        if (current != null && current.klass == klass) return current;
+        if (rejected == klass) return null;
+
+        Shape computed = computeShape(klass);
+        if (computed == null) rejected = klass;
+        else shape = computed;
+        return computed;
+    }
+
+    private Shape computeShape(CmelClass klass) {
+        for (String read : reads)
+            if (klass.findMethod(read) != null) return null;
+
+        CmelFunction initializer = klass.findMethod("init");
+        if (initializer == null) return new Shape(klass, 0, new String[0], new int[0], new Object[0]);
+
+        Statement.Function declaration = initializer.getDeclaration();
+        List<String> parameters = new ArrayList<>();
+        for (Token parameter : declaration.parameters) parameters.add(parameter.getLexeme());
+
+        // A field set twice keeps the later value.
+        Map<String, Expression> sources = new LinkedHashMap<>();
+        for (Statement statement : declaration.body) {
+            if (!(statement instanceof Statement.ExpressionStatement expression)
+                    || !(expression.expression instanceof Expression.Set set)
+                    || !(set.object instanceof Expression.This))
+                return null;
+            if (!(set.value instanceof Expression.Literal)
+                    && !(set.value instanceof Expression.Variable variable && parameters.contains(variable.name.getLexeme())))
+                return null;
+            sources.remove(set.name.getLexeme());
+            sources.put(set.name.getLexeme(), set.value);
+        }
+
+        String[] fields = new String[sources.size()];
+        int[] arguments = new int[fields.length];
+        Object[] constants = new Object[fields.length];
+        int i = 0;
+        for (Map.Entry<String, Expression> source : sources.entrySet()) {
+            fields[i] = source.getKey();
+            if (source.getValue() instanceof Expression.Variable variable) {
+                arguments[i] = parameters.indexOf(variable.name.getLexeme());
+            } else {
+                arguments[i] = -1;
+                constants[i] = ((Expression.Literal) source.getValue()).value;
+            }
+            i++;
+        }
+        return new Shape(klass, parameters.size(), fields, arguments, constants);
+    }
+}
@@ -4,6 +4,7 @@ import java.util.ArrayList;
 import java.util.HashMap;
 import java.util.List;
 import java.util.Map;
+import java.util.Stack;
 
 import static com.aidan.cmel.TokenType.*;
 
@@ -28,17 +29,45 @@ public class Scanner {
         keywords.put("this", THIS);
         keywords.put("var", VAR);
         keywords.put("while", WHILE);
+        keywords.put("comptime", COMPTIME);
+        keywords.put("parallel", PARALLEL);
+        keywords.put("atomic", ATOMIC);
     }
     private final String source;
     private final List<Token> tokens;
+    private final int end;
 
     private int start = 0;
     private int current = 0;
     private int line = 1;
+    private int next = 0;
+
+    // For a chunk scanned alongside others, its errors, to be reported in
+    // source order once all chunks are done; null otherwise.
+    private final List<Runnable> deferredErrors;
+    private boolean hadError = false;
+
+    // One entry per string interpolation being scanned, counting the braces
+    // opened inside its expression, so the '}' that ends it can be told apart.
+    private final Stack<Integer> interpolations = new Stack<>();
 
     public Scanner(String source) {
         this.source = source;
         tokens = new ArrayList<>();
+        end = source.length();
+        deferredErrors = null;
+    }
+
+    // Scans source[from, to), which starts on the given line, outside any
+    // string or comment.
+    Scanner(String source, int from, int to, int line) {
+        this.source = source;
+        tokens = new ArrayList<>();
+        end = to;
+        start = from;
+        current = from;
+        this.line = line;
+        deferredErrors = new ArrayList<>();
     }
 
     public List<Token> scanTokens() {
@@ -47,12 +76,45 @@ public class Scanner {
             scanToken();
         }
 
-        tokens.add(new Token(EOF, "", null, line));
+        tokens.add(new Token(EOF, "", null, line, current));
         return tokens;
     }
 
+    // Like scanTokens, but for a chunk that isn't the last: no EOF.
+    List<Token> scanChunk() {
+        while (!isAtEnd()) {
+            start = current;
+            scanToken();
+        }
+        return tokens;
+    }
+
+    void reportErrors() {
+        for (Runnable error : deferredErrors) error.run();
+    }
+
+    // Scans only as far as needed to produce the next token, so a parser can
+    // consume the source without the whole token list being built first.
+    public Token nextToken() {
+        if (next == tokens.size()) {
+            tokens.clear();
+            next = 0;
+        }
+
+        while (next == tokens.size()) {
+            if (isAtEnd()) {
+                tokens.add(new Token(EOF, "", null, line, current));
+                break;
+            }
+            start = current;
+            scanToken();
+        }
+
+        return tokens.get(next++);
+    }
+
     private boolean isAtEnd() {
-        return current >= source.length();
+        return current >= end;
     }
 
     private void scanToken() {
@@ -60,8 +122,21 @@ public class Scanner {
         switch (c) {
             case '(' -> addToken(LEFT_PAREN);
             case ')' -> addToken(RIGHT_PAREN);
-            case '{' -> addToken(LEFT_BRACE);
-            case '}' -> addToken(RIGHT_BRACE);
+            case '{' -> {
+                if (!interpolations.isEmpty()) interpolations.push(interpolations.pop() + 1);
+                addToken(LEFT_BRACE);
+            }
+            case '}' -> {
+                if (!interpolations.isEmpty() && interpolations.peek() == 0) {
+                    interpolations.pop();
+                    string();
+                } else {
+                    if (!interpolations.isEmpty()) interpolations.push(interpolations.pop() - 1);
+                    addToken(RIGHT_BRACE);
+                }
+            }
+            case '[' -> addToken(LEFT_BRACKET);
+            case ']' -> addToken(RIGHT_BRACKET);
             case ',' -> addToken(COMMA);
             case '.' -> addToken(DOT);
             case '+' -> addToken(PLUS);
@@ -76,7 +151,7 @@ public class Scanner {
             case '<' -> addToken(match('=') ? LESS_EQUAL : LESS);
             case '/' -> {
                 if (match('/'))
-                    while (peek() != '\n') advance();
+                    while (peek() != '\n' && !isAtEnd()) advance();
                 else
                     addToken(SLASH);
             }
@@ -91,11 +166,21 @@ public class Scanner {
                 else if (isAlpha(c))
                     identifier();
                 else
-                    Cmel.error(line, "Unexpected character.");
+                    error(line, "Unexpected character.");
             }
         }
     }
 
+    boolean hadError() {
+        return hadError;
+    }
+
+    private void error(int line, String message) {
+        hadError = true;
+        if (deferredErrors != null) deferredErrors.add(() -> Cmel.error(line, message));
+        else Cmel.error(line, message);
+    }
+
     private char advance() {
         return source.charAt(current++);
     }
@@ -113,22 +198,32 @@ public class Scanner {
         return source.charAt(current);
     }
 
+    // Scans the rest of a string, from just after its opening quote or the '}'
+    // closing an interpolated expression. A "${" ends the token early as an
+    // INTERPOLATION, and the expression after it is scanned as normal tokens.
     private void string() {
+        int contentStart = current;
         while (peek() != '"' && !isAtEnd()) {
+            if (peek() == '$' && peekNext() == '{') {
+                String value = source.substring(contentStart, current);
+                current += 2;
+                interpolations.push(0);
+                addToken(INTERPOLATION, value);
+                return;
+            }
             if (peek() == '\n') line++;
             advance();
         }
 
         if (isAtEnd()) {
-            Cmel.error(line, "Unterminated string.");
+            error(line, "Unterminated string.");
             return;
         }
 
+        String value = source.substring(contentStart, current);
+
         // To get passed the closing "
         advance();
-
-        // To get rid of the quotes and get the actual value
-        String value = source.substring(start + 1, current - 1);
         addToken(STRING, value);
     }
 
@@ -153,7 +248,7 @@ public class Scanner {
     }
 
     private char peekNext() {
-        if (current + 1 >= source.length()) return '\0';
+        if (current + 1 >= end) return '\0';
         return source.charAt(current + 1);
     }
 
@@ -179,7 +274,7 @@ public class Scanner {
 
     private void addToken(TokenType type, Object literal) {
         String text = source.substring(start, current);
-        tokens.add(new Token(type, text, literal, line));
+        tokens.add(new Token(type, text, literal, line, start));
     }
 }
 
@@ -0,0 +1,347 @@
+package com.aidan.cmel;
+
+import java.util.ArrayList;
+import java.util.IdentityHashMap;
+import java.util.List;
+import java.util.Map;
+
+import static com.aidan.cmel.TokenType.*;
+
+// A document open in the language server, kept as segments: runs of whole
+// lines holding complete top-level declarations. A top-level declaration only
+// refers to others through globals, which the resolver leaves alone, so each
+// segment is scanned, parsed and resolved on its own. An edit re-scans just
+// the segments it touches, splits the result into segments again, and parses
+// and resolves only those; every other segment keeps its tokens, tree and
+// resolution, and at most has its first line moved.
+final class ServerDocument {
+    // A range on one line: line and characters are zero-based, as the
+    // protocol counts them.
+    static final class Span {
+        final int line;
+        final int start;
+        final int end;
+
+        Span(int line, int start, int end) {
+            this.line = line;
+            this.start = start;
+            this.end = end;
+        }
+    }
+
+    static final class Diagnostic {
+        final Span span;
+        final String message;
+
+        Diagnostic(Span span, String message) {
+            this.span = span;
+            this.message = message;
+        }
+    }
+
+    private static final class Segment {
+        // Moved when an edit above changes the number of lines.
+        int line;
+        final String text;
+        // Where each of the segment's lines starts in text.
+        final int[] lineStarts;
+        final List<Token> tokens;
+        final List<Statement> statements;
+        // Lines relative to the segment.
+        final List<Diagnostic> diagnostics;
+        // For each name looked up, the token declaring it, or null for a
+        // global; declarations refer to themselves.
+        final Map<Token, Token> references;
+
+        Segment(String text, int[] lineStarts, List<Token> tokens, List<Statement> statements,
+                List<Diagnostic> diagnostics, Map<Token, Token> references) {
+            this.text = text;
+            this.lineStarts = lineStarts;
+            this.tokens = tokens;
+            this.statements = statements;
+            this.diagnostics = diagnostics;
+            this.references = references;
+        }
+
+        int lines() {
+            return lineStarts.length - 1;
+        }
+
+        Span span(Token token) {
+            int line = token.getLine() - 1;
+            int start = token.getOffset() - lineStarts[line];
+            int length = token.getLexeme().indexOf('\n') < 0 ? token.getLexeme().length() : 0;
+            return new Span(this.line + line, start, start + length);
+        }
+    }
+
+    private final List<Segment> segments = new ArrayList<>();
+    // Resolves each segment, and is reset afterwards so nothing builds up.
+    private final Interpreter context;
+
+    ServerDocument(String text, Interpreter base) {
+        context = new Interpreter(base);
+        replace(text);
+    }
+
+    void replace(String text) {
+        segments.clear();
+        for (String piece : split(text).pieces) segments.add(segment(piece));
+        if (segments.isEmpty()) segments.add(segment(""));
+        renumber(0);
+    }
+
+    void edit(int startLine, int startCharacter, int endLine, int endCharacter, String replacement) {
+        int first = segmentAt(startLine);
+        int end = segmentAt(endLine) + 1;
+
+        StringBuilder region = new StringBuilder();
+        for (int i = first; i < end; i++) region.append(segments.get(i).text);
+        int from = offsetIn(first, end, startLine, startCharacter);
+        int to = Math.max(from, offsetIn(first, end, endLine, endCharacter));
+        region.replace(from, to, replacement);
+
+        // A declaration left open takes in the rest of the document, split
+        // once; the pieces after where it closes that haven't changed keep
+        // their segments instead of being checked again.
+        Pieces pieces = split(region.toString());
+        int kept = end;
+        if (!pieces.complete && end < segments.size()) {
+            for (int i = end; i < segments.size(); i++) region.append(segments.get(i).text);
+            pieces = split(region.toString());
+            int piece = pieces.pieces.size();
+            kept = segments.size();
+            while (piece > 1 && kept > end && pieces.pieces.get(piece - 1).equals(segments.get(kept - 1).text)) {
+                piece--;
+                kept--;
+            }
+            pieces.pieces.subList(piece, pieces.pieces.size()).clear();
+        }
+
+        List<Segment> fresh = new ArrayList<>(pieces.pieces.size());
+        for (String piece : pieces.pieces) fresh.add(segment(piece));
+        segments.subList(first, kept).clear();
+        segments.addAll(first, fresh);
+        if (segments.isEmpty()) segments.add(segment(""));
+        renumber(Math.min(first, segments.size() - 1));
+    }
+
+    List<Diagnostic> diagnostics() {
+        List<Diagnostic> diagnostics = new ArrayList<>();
+        for (Segment segment : segments) {
+            for (Diagnostic diagnostic : segment.diagnostics) {
+                Span span = diagnostic.span;
+                diagnostics.add(new Diagnostic(new Span(segment.line + span.line, span.start, span.end), diagnostic.message));
+            }
+        }
+        return diagnostics;
+    }
+
+    // Where the name at the position is declared, or null when it is a native
+    // or isn't declared anywhere.
+    Span definition(int line, int character) {
+        Segment segment = segments.get(segmentAt(line));
+        Token token = tokenAt(segment, line, character);
+        if (token == null) return null;
+
+        Token declaration = segment.references.get(token);
+        if (declaration != null) return segment.span(declaration);
+        return global(token.getLexeme());
+    }
+
+    // Markdown describing the name at the position: the line declaring it.
+    String hover(int line, int character) {
+        Segment segment = segments.get(segmentAt(line));
+        Token token = tokenAt(segment, line, character);
+        if (token == null) return null;
+
+        Span declaration = definition(line, character);
+        if (declaration == null) {
+            if (segment.references.containsKey(token) && context.getGlobals().lookup(token.getLexeme()) instanceof CmelCallable)
+                return "`" + token.getLexeme() + "`: native function";
+            return null;
+        }
+        return "```cmel\n" + lineText(declaration.line).strip() + "\n```";
+    }
+
+    private Span global(String name) {
+        for (Segment segment : segments) {
+            for (Statement statement : segment.statements) {
+                Token declared = statement instanceof Statement.Var var ? var.name
+                        : statement instanceof Statement.Function function ? function.name
+                        : statement instanceof Statement.Class klass ? klass.name : null;
+                if (declared != null && declared.getLexeme().equals(name)) return segment.span(declared);
+            }
+        }
+        return null;
+    }
+
+    private String lineText(int line) {
+        Segment segment = segments.get(segmentAt(line));
+        int relative = Math.min(line - segment.line, segment.lines());
+        int start = segment.lineStarts[relative];
+        int end = relative + 1 < segment.lineStarts.length ? segment.lineStarts[relative + 1] : segment.text.length();
+        return segment.text.substring(start, end);
+    }
+
+    // The identifier or this at the position, including just after its end.
+    private Token tokenAt(Segment segment, int line, int character) {
+        int relative = line - segment.line;
+        if (relative > segment.lines()) return null;
+        int offset = segment.lineStarts[relative] + character;
+
+        List<Token> tokens = segment.tokens;
+        int lo = 0, hi = tokens.size() - 1;
+        while (lo < hi) {
+            int mid = (lo + hi + 1) >>> 1;
+            if (tokens.get(mid).getOffset() <= offset) lo = mid;
+            else hi = mid - 1;
+        }
+        for (int i = lo; i >= Math.max(0, lo - 1); i--) {
+            Token token = tokens.get(i);
+            if ((token.getType() == IDENTIFIER || token.getType() == THIS)
+                    && offset >= token.getOffset() && offset <= token.getOffset() + token.getLexeme().length())
+                return token;
+        }
+        return null;
+    }
+
+    // The last segment starting at or before line.
+    private int segmentAt(int line) {
+        int lo = 0, hi = segments.size() - 1;
+        while (lo < hi) {
+            int mid = (lo + hi + 1) >>> 1;
+            if (segments.get(mid).line <= line) lo = mid;
+            else hi = mid - 1;
+        }
+        return lo;
+    }
+
+    // The offset of a position in the text of segments [first, end).
+    private int offsetIn(int first, int end, int line, int character) {
+        int base = 0;
+        for (int i = first; i < end; i++) {
+            Segment segment = segments.get(i);
+            if (i == end - 1 || segments.get(i + 1).line > line) {
+                int relative = Math.max(0, Math.min(line - segment.line, segment.lines()));
+                int start = segment.lineStarts[relative];
+                int lineEnd = relative + 1 < segment.lineStarts.length ? segment.lineStarts[relative + 1] - 1 : segment.text.length();
+                return base + Math.min(start + character, Math.max(start, lineEnd));
+            }
+            base += segment.text.length();
+        }
+        return base;
+    }
+
+    private void renumber(int from) {
+        for (int i = from; i < segments.size(); i++) {
+            Segment previous = i == 0 ? null : segments.get(i - 1);
+            segments.get(i).line = previous == null ? 0 : previous.line + previous.lines();
+        }
+    }
+
+    private Segment segment(String text) {
+        int[] lineStarts = lineStarts(text);
+        List<Diagnostic> diagnostics = new ArrayList<>();
+        Map<Token, Token> references = new IdentityHashMap<>();
+        List<Token> tokens = List.of(new Token(EOF, "", null, 1, 0));
+        List<Statement> statements = new ArrayList<>();
+
+        Cmel.listenForErrors((line, token, message) -> diagnostics.add(diagnostic(text, lineStarts, line, token, message)));
+        try {
+            Scanner scanner = new Scanner(text);
+            tokens = scanner.scanTokens();
+            for (Statement statement : new Parser(tokens, scanner.hadError(), new Resolver(context, references::put)).parse())
+                if (statement != null) statements.add(statement);
+        } catch (RuntimeException | StackOverflowError e) {
+            diagnostics.add(new Diagnostic(new Span(0, 0, 0), "Couldn't check this declaration: " + e));
+        } finally {
+            Cmel.listenForErrors(null);
+            context.reset();
+        }
+        return new Segment(text, lineStarts, tokens, statements, diagnostics, references);
+    }
+
+    private static Diagnostic diagnostic(String text, int[] lineStarts, int line, Token token, String message) {
+        int relative = Math.max(0, Math.min(line - 1, lineStarts.length - 1));
+        if (token != null && token.getOffset() >= 0) {
+            int start = token.getOffset() - lineStarts[relative];
+            int length = token.getLexeme().indexOf('\n') < 0 ? token.getLexeme().length() : 0;
+            return new Diagnostic(new Span(relative, start, start + length), message);
+        }
+        int end = relative + 1 < lineStarts.length ? lineStarts[relative + 1] - 1 : text.length();
+        return new Diagnostic(new Span(relative, 0, end - lineStarts[relative]), message);
+    }
+
+    private static int[] lineStarts(String text) {
+        int lines = 0;
+        for (int i = 0; i < text.length(); i++)
+            if (text.charAt(i) == '\n') lines++;
+
+        int[] starts = new int[lines + 1];
+        for (int i = 0, line = 1; i < text.length(); i++)
+            if (text.charAt(i) == '\n') starts[line++] = i + 1;
+        return starts;
+    }
+
+    private static final class Pieces {
+        final List<String> pieces = new ArrayList<>();
+        boolean complete = true;
+    }
+
+    // Splits text after each line ending a top-level declaration: one whose
+    // last token is a ';' or '}' outside any brackets and isn't followed by an
+    // else. A named function or class starting a line also starts a piece, so
+    // an unclosed brace doesn't swallow the rest of the document.
+    private static Pieces split(String text) {
+        Pieces pieces = new Pieces();
+        List<Token> tokens;
+        Cmel.listenForErrors((line, token, message) -> {});
+        try {
+            tokens = new Scanner(text).scanTokens();
+        } catch (RuntimeException e) {
+            pieces.pieces.add(text);
+            return pieces;
+        } finally {
+            Cmel.listenForErrors(null);
+        }
+
+        int from = 0;
+        int depth = 0;
+        boolean open = false;
+        for (int i = 0; i < tokens.size() - 1; i++) {
+            Token token = tokens.get(i);
+            Token next = tokens.get(i + 1);
+            switch (token.getType()) {
+                case FUN, CLASS -> {
+                    int start = text.lastIndexOf('\n', token.getOffset() - 1) + 1;
+                    if (depth > 0 && start == token.getOffset() && next.getType() == IDENTIFIER && start > from) {
+                        pieces.pieces.add(text.substring(from, start));
+                        from = start;
+                        depth = 0;
+                    }
+                }
+                case LEFT_PAREN, LEFT_BRACKET, LEFT_BRACE -> depth++;
+                case RIGHT_PAREN, RIGHT_BRACKET, RIGHT_BRACE -> depth = Math.max(0, depth - 1);
+                default -> {}
+            }
+            open = true;
+
+            if (depth == 0 && (token.getType() == SEMICOLON || token.getType() == RIGHT_BRACE)) {
+                if (next.getType() == EOF) {
+                    open = false;
+                } else if (next.getLine() > token.getLine() && next.getType() != ELSE) {
+                    int newline = text.indexOf('\n', token.getOffset());
+                    int end = newline < 0 ? text.length() : newline + 1;
+                    pieces.pieces.add(text.substring(from, end));
+                    from = end;
+                    open = false;
+                }
+            }
+        }
+
+        if (from < text.length()) pieces.pieces.add(text.substring(from));
+        pieces.complete = !open;
+        return pieces;
+    }
+}
@@ -12,6 +12,8 @@ public abstract class Statement {
         R visitFunctionStatement(Function statement);
         R visitReturnStatement(Return statement);
         R visitClassStatement(Class statement);
+        R visitParallelForStatement(ParallelFor statement);
+        R visitAtomicStatement(Atomic statement);
     }
 
     abstract <R> R accept(Visitor<R> visitor);
@@ -56,6 +58,8 @@ public abstract class Statement {
     static class Var extends Statement {
         final Token name;
         final  Expression initializer;
+        ScalarReplacement scalar;
+        int numberSlot;
         public Var(Token name, Expression initializer) {
             this.name = name;
             this.initializer = initializer;
@@ -69,6 +73,8 @@ public abstract class Statement {
     static class While extends Statement {
         final Expression condition;
         final  Statement body;
+        boolean kernelChecked;
+        ArrayKernel kernel;
         public While(Expression condition, Statement body) {
             this.condition = condition;
             this.body = body;
@@ -120,4 +126,37 @@ public abstract class Statement {
             return visitor.visitClassStatement(this);
         }
     }
+    static class ParallelFor extends Statement {
+        final Token keyword;
+        final  Token variable;
+        final  Expression start;
+        final  Expression end;
+        final  Statement body;
+        EffectAnalyzer.Summary summary;
+        public ParallelFor(Token keyword, Token variable, Expression start, Expression end, Statement body) {
+            this.keyword = keyword;
+            this.variable = variable;
+            this.start = start;
+            this.end = end;
+            this.body = body;
+        }
+
+        @Override
+        <R> R accept(Visitor<R> visitor) {
+            return visitor.visitParallelForStatement(this);
+        }
+    }
+    static class Atomic extends Statement {
+        final Token keyword;
+        final  Statement body;
+        public Atomic(Token keyword, Statement body) {
+            this.keyword = keyword;
+            this.body = body;
+        }
+
+        @Override
+        <R> R accept(Visitor<R> visitor) {
+            return visitor.visitAtomicStatement(this);
+        }
+    }
 }
\ No newline at end of file
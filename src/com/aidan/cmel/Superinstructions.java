@@ -0,0 +1,48 @@
+package com.aidan.cmel;
+
+import java.io.PrintStream;
+import java.util.concurrent.atomic.LongAdder;
+
+// Counts, when asked to with --superinstructions, how often each fused node
+// runs against how often the general node it replaces still runs, and prints
+// the hit rates when the program ends.
+final class Superinstructions {
+    enum Pattern {
+        LESS_THAN_CONSTANT("variable < number", "<"),
+        INCREMENT("x = x + number", "assignment"),
+        THIS_FIELD("this.field", "property read"),
+        CALL_VARIABLE("call of a variable", "call");
+
+        final String description;
+        final String general;
+        final LongAdder fused = new LongAdder();
+        final LongAdder unfused = new LongAdder();
+
+        Pattern(String description, String general) {
+            this.description = description;
+            this.general = general;
+        }
+    }
+
+    static boolean counting = false;
+
+    private Superinstructions() {}
+
+    static void fused(Pattern pattern) {
+        if (counting) pattern.fused.increment();
+    }
+
+    static void unfused(Pattern pattern) {
+        if (counting) pattern.unfused.increment();
+    }
+
+    static void report(PrintStream out) {
+        out.println("superinstruction        fused    of all     hit rate");
+        for (Pattern pattern : Pattern.values()) {
+            long fused = pattern.fused.sum();
+            long total = fused + pattern.unfused.sum();
+            double rate = total == 0 ? 0 : 100.0 * fused / total;
+            out.printf("%-20s %10d %9d  %6.1f%% of %ss%n", pattern.description, fused, total, rate, pattern.general);
+        }
+    }
+}
@@ -0,0 +1,77 @@
+package com.aidan.cmel;
+
+import java.util.concurrent.atomic.AtomicLong;
+
+// A transactional field. The stamp is the clock version at which the value was
+// last committed, shifted left one bit; an odd stamp means a committing
+// transaction holds the field locked.
+final class TVar {
+    // The value of a field created by a transaction that hasn't committed yet.
+    static final Object ABSENT = new Object();
+
+    private final AtomicLong stamp = new AtomicLong();
+    private volatile Object value;
+    // Set once a transaction has touched the field. Until then no transaction
+    // can be validating it, so plain writes needn't take a version.
+    private volatile boolean watched = false;
+
+    TVar(Object value) {
+        this.value = value;
+    }
+
+    // Reads and writes outside a transaction. A plain write to a watched
+    // field takes the lock and a new version, so that transactions which read
+    // it see the change when they validate. The value is written before
+    // watched is checked, and a transaction sets watched before reading, so
+    // either the transaction reads the new value or the write bumps the
+    // version.
+    Object get() {
+        return value;
+    }
+
+    void set(Object value) {
+        if (!watched) {
+            this.value = value;
+            if (!watched) return;
+        }
+        while (!tryLock())
+            Thread.onSpinWait();
+        publish(value, Transaction.tick());
+    }
+
+    void watch() {
+        if (!watched) watched = true;
+    }
+
+    // Answers the value only if it was committed no later than readVersion and
+    // no commit is under way; otherwise the reading transaction must retry.
+    Object read(long readVersion) {
+        long before = stamp.get();
+        Object result = value;
+        long after = stamp.get();
+        if (before != after || (before & 1) != 0 || (before >>> 1) > readVersion)
+            throw Transaction.Conflict.INSTANCE;
+        return result;
+    }
+
+    boolean isValid(long readVersion, boolean lockedByReader) {
+        long current = stamp.get();
+        if ((current & 1) != 0 && !lockedByReader) return false;
+        return (current >>> 1) <= readVersion;
+    }
+
+    boolean tryLock() {
+        long current = stamp.get();
+        return (current & 1) == 0 && stamp.compareAndSet(current, current | 1);
+    }
+
+    void unlock() {
+        stamp.set(stamp.get() & ~1L);
+    }
+
+    // Stores a value and releases the lock in one step.
+    void publish(Object value, long version) {
+        this.value = value;
+        stamp.set(version << 1);
+    }
+}
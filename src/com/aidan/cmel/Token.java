@@ -5,12 +5,20 @@ public class Token {
     private final String lexeme;
     private final Object literal;
     private final int line;
+    // Where the token starts in the source it was scanned from, or -1 for a
+    // token made some other way.
+    private final int offset;
 
     public Token(TokenType type, String lexeme, Object literal, int line) {
+        this(type, lexeme, literal, line, -1);
+    }
+
+    public Token(TokenType type, String lexeme, Object literal, int line, int offset) {
         this.type = type;
         this.lexeme = lexeme;
         this.literal = literal;
         this.line = line;
+        this.offset = offset;
     }
 
     public String toString() {
@@ -32,4 +40,8 @@ public class Token {
     public int getLine() {
         return line;
     }
+
+    public int getOffset() {
+        return offset;
+    }
 }
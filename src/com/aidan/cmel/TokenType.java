@@ -3,6 +3,7 @@ package com.aidan.cmel;
 public enum TokenType {
     // single char tokens
     LEFT_PAREN, RIGHT_PAREN, LEFT_BRACE, RIGHT_BRACE,
+    LEFT_BRACKET, RIGHT_BRACKET,
     COMMA, DOT, PLUS, MINUS, SEMICOLON, SLASH, STAR,
     QUESTION, COLON,
 
@@ -13,11 +14,11 @@ public enum TokenType {
     LESS, LESS_EQUAL,
 
     // literals
-    IDENTIFIER, STRING, NUMBER,
+    IDENTIFIER, STRING, INTERPOLATION, NUMBER,
 
     // keywords
     AND, OR, CLASS, FUN, IF, ELSE, FOR, FALSE, TRUE, NIL,
-    RETURN, SUPER, THIS, VAR, WHILE,
+    RETURN, SUPER, THIS, VAR, WHILE, COMPTIME, PARALLEL, ATOMIC,
 
     EOF
 }
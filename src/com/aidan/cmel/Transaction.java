@@ -0,0 +1,100 @@
+package com.aidan.cmel;
+
+import java.util.ArrayList;
+import java.util.IdentityHashMap;
+import java.util.List;
+import java.util.Map;
+import java.util.concurrent.ThreadLocalRandom;
+import java.util.concurrent.atomic.AtomicLong;
+import java.util.concurrent.locks.LockSupport;
+
+// One attempt at an atomic block, in the style of TL2. Reads are optimistic and
+// checked against the version of the global clock the attempt started at;
+// writes are buffered until commit, which locks the written fields, takes a
+// new version and re-validates what was read. A read-only attempt commits
+// without doing anything.
+final class Transaction {
+    // Thrown to abandon an attempt. Carries no stack trace, as it is routine.
+    static final class Conflict extends RuntimeException {
+        static final Conflict INSTANCE = new Conflict();
+
+        private Conflict() {
+            super(null, null, false, false);
+        }
+    }
+
+    private static final AtomicLong clock = new AtomicLong();
+
+    private final long readVersion = clock.get();
+    private final List<TVar> reads = new ArrayList<>();
+    private final Map<TVar, Object> writes = new IdentityHashMap<>();
+    // Restores local variables the attempt assigned, for when it is abandoned.
+    private final List<Runnable> undo = new ArrayList<>();
+
+    static long tick() {
+        return clock.incrementAndGet();
+    }
+
+    Object read(TVar field) {
+        if (!writes.isEmpty() && writes.containsKey(field)) return writes.get(field);
+
+        field.watch();
+        Object value = field.read(readVersion);
+        reads.add(field);
+        return value;
+    }
+
+    void write(TVar field, Object value) {
+        field.watch();
+        writes.put(field, value);
+    }
+
+    // Locals aren't versioned, so their writes are made directly and undone,
+    // newest first, if the attempt doesn't commit.
+    void onAbort(Runnable restore) {
+        undo.add(restore);
+    }
+
+    void rollBack() {
+        for (int i = undo.size() - 1; i >= 0; i--) undo.get(i).run();
+        undo.clear();
+    }
+
+    // Answers false if another commit got in the way, in which case nothing
+    // has been written and the block should be run again.
+    boolean commit() {
+        if (writes.isEmpty()) return true;
+
+        List<TVar> locked = new ArrayList<>(writes.size());
+        try {
+            for (TVar field : writes.keySet()) {
+                if (!field.tryLock()) return false;
+                locked.add(field);
+            }
+
+            long writeVersion = tick();
+            if (writeVersion != readVersion + 1) {
+                for (TVar field : reads)
+                    if (!field.isValid(readVersion, writes.containsKey(field))) return false;
+            }
+
+            for (Map.Entry<TVar, Object> write : writes.entrySet())
+                write.getKey().publish(write.getValue(), writeVersion);
+            locked.clear();
+            return true;
+        } finally {
+            for (TVar field : locked) field.unlock();
+        }
+    }
+
+    // Spins for the first few retries, then sleeps for a random, growing time
+    // so that transactions which keep colliding drift apart.
+    static void backoff(int attempt) {
+        if (attempt < 4) {
+            Thread.onSpinWait();
+            return;
+        }
+        long limit = 1L << Math.min(attempt, 20);
+        LockSupport.parkNanos(ThreadLocalRandom.current().nextLong(limit));
+    }
+}
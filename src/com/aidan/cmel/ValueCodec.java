@@ -0,0 +1,177 @@
+package com.aidan.cmel;
+
+import com.aidan.cmel.collections.PersistentHashMap;
+import com.aidan.cmel.collections.PersistentVector;
+import com.aidan.cmel.collections.TransientHashMap;
+import com.aidan.cmel.collections.TransientVector;
+
+import java.io.DataInput;
+import java.io.DataOutput;
+import java.io.IOException;
+import java.nio.charset.StandardCharsets;
+
+// A binary encoding of Cmel's plain data: nil, booleans, numbers, strings,
+// persistent collections and arrays. Functions, classes and instances belong
+// to one interpreter and can't be encoded.
+public final class ValueCodec {
+    private static final int NIL = 0;
+    private static final int FALSE = 1;
+    private static final int TRUE = 2;
+    private static final int NUMBER = 3;
+    private static final int STRING = 4;
+    private static final int VECTOR = 5;
+    private static final int MAP = 6;
+    private static final int ARRAY = 7;
+    private static final int FLOAT64_ARRAY = 8;
+    private static final int INT32_ARRAY = 9;
+    private static final int FLOAT32_ARRAY = 10;
+    private static final int UINT8_ARRAY = 11;
+
+    private ValueCodec() {}
+
+    public static boolean canEncode(Object value) {
+        if (value == null || value instanceof Boolean || value instanceof Double || value instanceof String)
+            return true;
+        if (value instanceof PersistentVector vector) {
+            for (int i = 0; i < vector.count(); i++)
+                if (!canEncode(vector.nth(i))) return false;
+            return true;
+        }
+        if (value instanceof PersistentHashMap map) {
+            boolean[] encodable = {true};
+            map.forEach((key, element) -> encodable[0] &= canEncode(key) && canEncode(element));
+            return encodable[0];
+        }
+        if (value instanceof CmelArray array) {
+            for (int i = 0; i < array.length(); i++)
+                if (!canEncode(array.get((double) i))) return false;
+            return true;
+        }
+        return value instanceof CmelTypedArray;
+    }
+
+    public static void write(DataOutput out, Object value) throws IOException {
+        if (value == null) {
+            out.writeByte(NIL);
+        } else if (value instanceof Boolean bool) {
+            out.writeByte(bool ? TRUE : FALSE);
+        } else if (value instanceof Double number) {
+            out.writeByte(NUMBER);
+            out.writeDouble(number);
+        } else if (value instanceof String string) {
+            byte[] bytes = string.getBytes(StandardCharsets.UTF_8);
+            out.writeByte(STRING);
+            out.writeInt(bytes.length);
+            out.write(bytes);
+        } else if (value instanceof PersistentVector vector) {
+            out.writeByte(VECTOR);
+            out.writeInt(vector.count());
+            for (int i = 0; i < vector.count(); i++)
+                write(out, vector.nth(i));
+        } else if (value instanceof PersistentHashMap map) {
+            out.writeByte(MAP);
+            out.writeInt(map.count());
+            IOException[] failure = {null};
+            map.forEach((key, element) -> {
+                if (failure[0] != null) return;
+                try {
+                    write(out, key);
+                    write(out, element);
+                } catch (IOException e) {
+                    failure[0] = e;
+                }
+            });
+            if (failure[0] != null) throw failure[0];
+        } else if (value instanceof CmelArray array) {
+            out.writeByte(ARRAY);
+            out.writeInt(array.length());
+            for (int i = 0; i < array.length(); i++)
+                write(out, array.get((double) i));
+        } else if (value instanceof CmelFloat64Array array) {
+            out.writeByte(FLOAT64_ARRAY);
+            out.writeInt(array.elements.length);
+            for (double element : array.elements)
+                out.writeDouble(element);
+        } else if (value instanceof CmelInt32Array array) {
+            int[] elements = (int[]) array.storage();
+            out.writeByte(INT32_ARRAY);
+            out.writeInt(elements.length);
+            for (int element : elements)
+                out.writeInt(element);
+        } else if (value instanceof CmelFloat32Array array) {
+            float[] elements = (float[]) array.storage();
+            out.writeByte(FLOAT32_ARRAY);
+            out.writeInt(elements.length);
+            for (float element : elements)
+                out.writeFloat(element);
+        } else if (value instanceof CmelUint8Array array) {
+            byte[] elements = (byte[]) array.storage();
+            out.writeByte(UINT8_ARRAY);
+            out.writeInt(elements.length);
+            out.write(elements);
+        } else {
+            throw new RuntimeError("Can't encode " + Interpreter.stringify(value) + "; only plain data can leave the interpreter.");
+        }
+    }
+
+    public static Object read(DataInput in) throws IOException {
+        int tag = in.readUnsignedByte();
+        switch (tag) {
+            case NIL -> { return null; }
+            case FALSE -> { return false; }
+            case TRUE -> { return true; }
+            case NUMBER -> { return in.readDouble(); }
+            case STRING -> {
+                byte[] bytes = new byte[in.readInt()];
+                in.readFully(bytes);
+                return new String(bytes, StandardCharsets.UTF_8);
+            }
+            case VECTOR -> {
+                int count = in.readInt();
+                TransientVector vector = PersistentVector.EMPTY.asTransient();
+                for (int i = 0; i < count; i++)
+                    vector.conj(read(in));
+                return vector.persistent();
+            }
+            case MAP -> {
+                int count = in.readInt();
+                TransientHashMap map = PersistentHashMap.EMPTY.asTransient();
+                for (int i = 0; i < count; i++)
+                    map.assoc(read(in), read(in));
+                return map.persistent();
+            }
+            case ARRAY -> {
+                CmelArray array = new CmelArray(in.readInt());
+                for (int i = 0; i < array.length(); i++)
+                    array.set((double) i, read(in));
+                return array;
+            }
+            case FLOAT64_ARRAY -> {
+                CmelFloat64Array array = new CmelFloat64Array(in.readInt());
+                for (int i = 0; i < array.elements.length; i++)
+                    array.elements[i] = in.readDouble();
+                return array;
+            }
+            case INT32_ARRAY -> {
+                CmelInt32Array array = new CmelInt32Array(in.readInt());
+                int[] elements = (int[]) array.storage();
+                for (int i = 0; i < elements.length; i++)
+                    elements[i] = in.readInt();
+                return array;
+            }
+            case FLOAT32_ARRAY -> {
+                CmelFloat32Array array = new CmelFloat32Array(in.readInt());
+                float[] elements = (float[]) array.storage();
+                for (int i = 0; i < elements.length; i++)
+                    elements[i] = in.readFloat();
+                return array;
+            }
+            case UINT8_ARRAY -> {
+                CmelUint8Array array = new CmelUint8Array(in.readInt());
+                in.readFully((byte[]) array.storage());
+                return array;
+            }
+        }
+        throw new IOException("Unknown value tag " + tag + ".");
+    }
+}
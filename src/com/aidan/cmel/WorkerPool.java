@@ -0,0 +1,282 @@
+package com.aidan.cmel;
+
+import com.aidan.cmel.collections.PersistentVector;
+import com.aidan.cmel.collections.TransientVector;
+
+import java.io.BufferedInputStream;
+import java.io.BufferedOutputStream;
+import java.io.ByteArrayOutputStream;
+import java.io.DataInputStream;
+import java.io.DataOutputStream;
+import java.io.IOException;
+import java.util.ArrayDeque;
+import java.util.ArrayList;
+import java.util.Deque;
+import java.util.HashSet;
+import java.util.List;
+import java.util.Set;
+import java.util.concurrent.BlockingQueue;
+import java.util.concurrent.LinkedBlockingQueue;
+import java.util.concurrent.TimeUnit;
+
+// Local worker processes, each a JVM running the same script with --worker.
+// A function is shipped by name, since every worker has loaded the script's
+// top-level declarations, together with the parent's global data values. Each
+// input then goes to whichever worker has room, at most IN_FLIGHT at a time per
+// worker, and results are collected in whatever order they finish. A worker
+// that dies is restarted and its unfinished inputs are sent again.
+public final class WorkerPool {
+    // Parent to worker.
+    static final int BEGIN = 1;
+    static final int TASK = 2;
+    // Worker to parent.
+    static final int RESULT = 1;
+    static final int FAILED = 2;
+
+    private static final int IN_FLIGHT = 2;
+    private static final int MAX_ATTEMPTS = 3;
+
+    private final String script;
+    private final Worker[] workers;
+    private final BlockingQueue<Event> events = new LinkedBlockingQueue<>();
+    private int nextTask = 0;
+    private boolean closed = false;
+
+    private WorkerPool(String script, int size) {
+        this.script = script;
+        this.workers = new Worker[size];
+        for (int i = 0; i < size; i++)
+            workers[i] = new Worker();
+    }
+
+    public static WorkerPool start(int size) {
+        String script = Cmel.scriptPath();
+        if (script == null)
+            throw new RuntimeError("Workers can only be used when running a script.");
+        if (size < 1)
+            throw new RuntimeError("A worker pool needs at least one worker.");
+        return new WorkerPool(script, size);
+    }
+
+    // Calls function on every input in the workers, answering the results in
+    // input order.
+    public PersistentVector map(Interpreter interpreter, Object callee, List<Object> inputs) {
+        if (closed) throw new RuntimeError("Worker pool has been closed.");
+        byte[] begin = encodeBegin(interpreter, callee);
+
+        int count = inputs.size();
+        int base = nextTask;
+        nextTask += count;
+        byte[][] encoded = new byte[count][];
+        for (int i = 0; i < count; i++)
+            encoded[i] = encodeTask(base + i, inputs.get(i));
+
+        Object[] results = new Object[count];
+        int[] attempts = new int[count];
+        Deque<Integer> pending = new ArrayDeque<>();
+        for (int i = 0; i < count; i++) pending.add(i);
+
+        for (Worker worker : workers) {
+            worker.inFlight.clear();
+            worker.begun = false;
+        }
+
+        int remaining = count;
+        try {
+            while (remaining > 0) {
+                for (Worker worker : workers)
+                    dispatch(worker, begin, base, encoded, pending);
+
+                Event event = events.take();
+                Worker worker = event.worker;
+                if (event.generation != worker.generation) continue;
+
+                if (event.crashed) {
+                    for (int task : worker.inFlight) {
+                        int index = task - base;
+                        if (++attempts[index] >= MAX_ATTEMPTS)
+                            throw new RuntimeError("A worker crashed " + MAX_ATTEMPTS + " times on input " + index + ".");
+                        pending.addFirst(index);
+                    }
+                    worker.restart();
+                    continue;
+                }
+
+                int index = event.task - base;
+                if (index < 0 || index >= count || !worker.inFlight.remove(event.task)) continue;
+                if (event.error != null)
+                    throw new RuntimeError("Worker failed on input " + index + ": " + event.error);
+
+                results[index] = event.value;
+                remaining--;
+            }
+        } catch (InterruptedException e) {
+            Thread.currentThread().interrupt();
+            throw new RuntimeError("Interrupted while waiting for workers.");
+        }
+
+        TransientVector vector = PersistentVector.EMPTY.asTransient();
+        for (Object result : results) vector.conj(result);
+        return vector.persistent();
+    }
+
+    private void dispatch(Worker worker, byte[] begin, int base, byte[][] encoded, Deque<Integer> pending) {
+        if (pending.isEmpty() || worker.inFlight.size() >= IN_FLIGHT) return;
+        try {
+            if (!worker.begun) {
+                worker.out.write(begin);
+                worker.begun = true;
+            }
+            while (!pending.isEmpty() && worker.inFlight.size() < IN_FLIGHT) {
+                int index = pending.poll();
+                worker.inFlight.add(base + index);
+                worker.out.write(encoded[index]);
+            }
+            worker.out.flush();
+        } catch (IOException e) {
+            // The worker's reader will see it die and report the crash.
+        }
+    }
+
+    public void close() {
+        if (closed) return;
+        closed = true;
+        for (Worker worker : workers) worker.stop();
+    }
+
+    // Ships the function by name, with every global that holds plain data.
+    private static byte[] encodeBegin(Interpreter interpreter, Object callee) {
+        if (!(callee instanceof CmelFunction function)
+                || interpreter.getGlobals().lookup(function.getDeclaration().name.getLexeme()) != function)
+            throw new RuntimeError("Only functions declared at the top level of the script can run in workers.");
+        if (function.arity() != 1)
+            throw new RuntimeError("Worker functions must take exactly one argument.");
+
+        List<String> names = new ArrayList<>();
+        List<Object> values = new ArrayList<>();
+        interpreter.getGlobals().forEach((name, value) -> {
+            if (!(value instanceof CmelCallable) && ValueCodec.canEncode(value)) {
+                names.add(name);
+                values.add(value);
+            }
+        });
+
+        ByteArrayOutputStream bytes = new ByteArrayOutputStream();
+        try (DataOutputStream out = new DataOutputStream(bytes)) {
+            out.writeByte(BEGIN);
+            out.writeUTF(function.getDeclaration().name.getLexeme());
+            out.writeInt(names.size());
+            for (int i = 0; i < names.size(); i++) {
+                out.writeUTF(names.get(i));
+                ValueCodec.write(out, values.get(i));
+            }
+        } catch (IOException e) {
+            throw new RuntimeError("Could not encode worker globals: " + e.getMessage());
+        }
+        return bytes.toByteArray();
+    }
+
+    private static byte[] encodeTask(int task, Object input) {
+        ByteArrayOutputStream bytes = new ByteArrayOutputStream();
+        try (DataOutputStream out = new DataOutputStream(bytes)) {
+            out.writeByte(TASK);
+            out.writeInt(task);
+            ValueCodec.write(out, input);
+        } catch (IOException e) {
+            throw new RuntimeError("Could not encode worker input: " + e.getMessage());
+        }
+        return bytes.toByteArray();
+    }
+
+    private static final class Event {
+        final Worker worker;
+        final int generation;
+        final boolean crashed;
+        final int task;
+        final Object value;
+        final String error;
+
+        Event(Worker worker, int generation, boolean crashed, int task, Object value, String error) {
+            this.worker = worker;
+            this.generation = generation;
+            this.crashed = crashed;
+            this.task = task;
+            this.value = value;
+            this.error = error;
+        }
+    }
+
+    private final class Worker {
+        final Set<Integer> inFlight = new HashSet<>();
+        Process process;
+        DataOutputStream out;
+        int generation = 0;
+        boolean begun = false;
+
+        Worker() {
+            launch();
+        }
+
+        private void launch() {
+            String java = ProcessHandle.current().info().command().orElse("java");
+            ProcessBuilder builder = new ProcessBuilder(java, "-cp", System.getProperty("java.class.path"),
+                    Cmel.class.getName(), "--worker", script);
+            builder.redirectError(ProcessBuilder.Redirect.INHERIT);
+            try {
+                process = builder.start();
+            } catch (IOException e) {
+                throw new RuntimeError("Could not start a worker: " + e.getMessage());
+            }
+            out = new DataOutputStream(new BufferedOutputStream(process.getOutputStream()));
+
+            int launched = generation;
+            DataInputStream in = new DataInputStream(new BufferedInputStream(process.getInputStream()));
+            Thread reader = new Thread(() -> read(in, launched), "cmel-worker-reader");
+            reader.setDaemon(true);
+            reader.start();
+        }
+
+        private void read(DataInputStream in, int launched) {
+            try {
+                while (true) {
+                    int tag = in.read();
+                    if (tag < 0) break;
+                    int task = in.readInt();
+                    if (tag == RESULT)
+                        events.add(new Event(this, launched, false, task, ValueCodec.read(in), null));
+                    else
+                        events.add(new Event(this, launched, false, task, null, in.readUTF()));
+                }
+            } catch (IOException | RuntimeError e) {
+                // Treated the same as the process exiting.
+            }
+            events.add(new Event(this, launched, true, -1, null, null));
+        }
+
+        void restart() {
+            process.destroyForcibly();
+            inFlight.clear();
+            begun = false;
+            generation++;
+            launch();
+        }
+
+        void stop() {
+            generation++;
+            try {
+                out.close();
+                if (!process.waitFor(1, TimeUnit.SECONDS)) process.destroyForcibly();
+            } catch (IOException e) {
+                process.destroyForcibly();
+            } catch (InterruptedException e) {
+                Thread.currentThread().interrupt();
+                process.destroyForcibly();
+            }
+        }
+    }
+
+    @Override
+    public String toString() {
+        return "<worker pool of " + workers.length + ">";
+    }
+}
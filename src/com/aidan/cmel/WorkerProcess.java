@@ -0,0 +1,69 @@
+package com.aidan.cmel;
+
+import java.io.BufferedInputStream;
+import java.io.BufferedOutputStream;
+import java.io.ByteArrayOutputStream;
+import java.io.DataInputStream;
+import java.io.DataOutputStream;
+import java.io.EOFException;
+import java.io.IOException;
+import java.io.PrintStream;
+import java.util.Collections;
+
+import static com.aidan.cmel.WorkerPool.*;
+
+// The worker side of a WorkerPool. Standard input and output carry the
+// protocol, so anything the script prints goes to standard error instead.
+final class WorkerProcess {
+    private WorkerProcess() {}
+
+    static void serve(Interpreter interpreter) throws IOException {
+        PrintStream protocol = System.out;
+        System.setOut(System.err);
+
+        DataInputStream in = new DataInputStream(new BufferedInputStream(System.in));
+        DataOutputStream out = new DataOutputStream(new BufferedOutputStream(protocol));
+        CmelCallable function = null;
+
+        while (true) {
+            int tag = in.read();
+            if (tag < 0) return;
+
+            if (tag == BEGIN) {
+                String name = in.readUTF();
+                int count = in.readInt();
+                for (int i = 0; i < count; i++)
+                    interpreter.getGlobals().define(in.readUTF(), ValueCodec.read(in));
+                function = interpreter.getGlobals().lookup(name) instanceof CmelFunction found ? found : null;
+            } else if (tag == TASK) {
+                int task = in.readInt();
+                Object input = ValueCodec.read(in);
+                out.write(run(function, interpreter, task, input));
+                out.flush();
+            } else {
+                throw new EOFException("Unknown message " + tag + ".");
+            }
+        }
+    }
+
+    // Encodes the whole reply before any of it is sent, so that a result that
+    // can't be encoded becomes a failure rather than a broken stream.
+    private static byte[] run(CmelCallable function, Interpreter interpreter, int task, Object input) throws IOException {
+        ByteArrayOutputStream bytes = new ByteArrayOutputStream();
+        DataOutputStream reply = new DataOutputStream(bytes);
+        try {
+            if (function == null) throw new RuntimeError("Worker has no such function.");
+            Object result = function.call(interpreter, Collections.singletonList(input));
+
+            reply.writeByte(RESULT);
+            reply.writeInt(task);
+            ValueCodec.write(reply, result);
+        } catch (RuntimeError error) {
+            bytes.reset();
+            reply.writeByte(FAILED);
+            reply.writeInt(task);
+            reply.writeUTF(error.getMessage());
+        }
+        return bytes.toByteArray();
+    }
+}
@@ -0,0 +1,132 @@
+package com.aidan.cmel.collections;
+
+import com.aidan.cmel.CmelCallable;
+import com.aidan.cmel.CmelIndexable;
+import com.aidan.cmel.Interpreter;
+import com.aidan.cmel.RuntimeError;
+
+import java.util.Collections;
+import java.util.concurrent.CompletableFuture;
+import java.util.concurrent.ConcurrentHashMap;
+
+// A mutable map that any number of threads can share. Reads are plain
+// ConcurrentHashMap gets, which never lock. computeIfAbsent claims a key with a
+// Pending entry before calling the Cmel function, so the function runs outside
+// any of the map's locks and at most once per key; other threads asking for
+// the same key wait for its result.
+public final class ConcurrentMap implements CmelIndexable {
+    private static final Object NIL_VALUE = new Object();
+
+    private final ConcurrentHashMap<Object, Object> entries = new ConcurrentHashMap<>();
+
+    private static final class Pending {
+        final Thread owner = Thread.currentThread();
+        final CompletableFuture<Object> result = new CompletableFuture<>();
+    }
+
+    // What waiters on a Pending get when its function failed.
+    private static final Object FAILED = new Object();
+
+    // A key whose value is still being computed reads as absent.
+    @Override
+    public Object get(Object key) {
+        Object value = entries.get(PersistentHashMap.box(key));
+        if (value == null || value instanceof Pending) return null;
+        return unbox(value);
+    }
+
+    @Override
+    public void set(Object key, Object value) {
+        entries.put(PersistentHashMap.box(key), box(value));
+    }
+
+    @Override
+    public int length() {
+        return entries.size();
+    }
+
+    // Answers the value already there, or nil after storing the new one.
+    public Object putIfAbsent(Object key, Object value) {
+        Object boxed = PersistentHashMap.box(key);
+        while (true) {
+            Object existing = entries.putIfAbsent(boxed, box(value));
+            if (existing == null) return null;
+            if (!(existing instanceof Pending pending)) return unbox(existing);
+
+            Object computed = await(pending);
+            if (computed != FAILED) return computed;
+        }
+    }
+
+    public Object computeIfAbsent(Interpreter interpreter, Object key, CmelCallable function) {
+        Object boxed = PersistentHashMap.box(key);
+        while (true) {
+            Object existing = entries.get(boxed);
+            if (existing == null) {
+                Pending pending = new Pending();
+                existing = entries.putIfAbsent(boxed, pending);
+                if (existing == null) return compute(interpreter, boxed, key, function, pending);
+            }
+            if (!(existing instanceof Pending pending)) return unbox(existing);
+
+            // Another thread is computing this key; if it fails, try again.
+            Object computed = await(pending);
+            if (computed != FAILED) return computed;
+        }
+    }
+
+    private Object compute(Interpreter interpreter, Object boxed, Object key, CmelCallable function, Pending pending) {
+        Object value;
+        try {
+            value = function.call(interpreter, Collections.singletonList(key));
+        } catch (RuntimeException | Error e) {
+            entries.remove(boxed, pending);
+            pending.result.complete(FAILED);
+            throw e;
+        }
+        entries.replace(boxed, pending, box(value));
+        pending.result.complete(value);
+        return value;
+    }
+
+    private static Object await(Pending pending) {
+        if (pending.owner == Thread.currentThread() && !pending.result.isDone())
+            throw new RuntimeError("computeIfAbsent's function asked for the key it is computing.");
+        return pending.result.join();
+    }
+
+    // Adds delta to the number stored under key, starting from zero, with a
+    // compare-and-set loop rather than a lock, and answers the new value.
+    public double increment(Object key, double delta) {
+        Object boxed = PersistentHashMap.box(key);
+        while (true) {
+            Object existing = entries.get(boxed);
+            if (existing == null) {
+                if (entries.putIfAbsent(boxed, delta) == null) return delta;
+                continue;
+            }
+            if (existing instanceof Pending pending) {
+                await(pending);
+                continue;
+            }
+            if (!(existing instanceof Double count))
+                throw new RuntimeError("Can only increment a number.");
+
+            double sum = count + delta;
+            if (entries.replace(boxed, existing, sum)) return sum;
+        }
+    }
+
+    private static Object box(Object value) {
+        return value == null ? NIL_VALUE : value;
+    }
+
+    private static Object unbox(Object value) {
+        return value == NIL_VALUE ? null : value;
+    }
+
+    @Override
+    public String toString() {
+        return "<concurrent map>";
+    }
+}
@@ -0,0 +1,380 @@
+package com.aidan.cmel.collections;
+
+import com.aidan.cmel.CmelIndexable;
+import com.aidan.cmel.Interpreter;
+import com.aidan.cmel.RuntimeError;
+
+import java.util.Objects;
+import java.util.concurrent.atomic.AtomicReference;
+import java.util.function.BiConsumer;
+
+// A hash array mapped trie. Each level consumes five bits of the key's hash and
+// stores only the occupied slots, so an update copies one small node per level.
+public final class PersistentHashMap implements CmelIndexable {
+    static final Object NIL_KEY = new Object() {
+        @Override
+        public String toString() {
+            return "nil";
+        }
+    };
+
+    public static final PersistentHashMap EMPTY = new PersistentHashMap(0, null);
+
+    final int count;
+    final Node root;
+
+    PersistentHashMap(int count, Node root) {
+        this.count = count;
+        this.root = root;
+    }
+
+    public int count() {
+        return count;
+    }
+
+    @Override
+    public Object get(Object key) {
+        if (root == null) return null;
+        Object boxed = box(key);
+        return root.find(0, boxed.hashCode(), boxed);
+    }
+
+    @Override
+    public void set(Object key, Object value) {
+        throw new RuntimeError("Can't assign into a persistent map; use assoc.");
+    }
+
+    @Override
+    public int length() {
+        return count;
+    }
+
+    public PersistentHashMap assoc(Object key, Object value) {
+        Object boxed = box(key);
+        Box addedLeaf = new Box();
+        Node start = root == null ? BitmapNode.EMPTY : root;
+        Node newRoot = start.assoc(null, 0, boxed.hashCode(), boxed, value, addedLeaf);
+        if (newRoot == root) return this;
+        return new PersistentHashMap(addedLeaf.value ? count + 1 : count, newRoot);
+    }
+
+    public PersistentHashMap without(Object key) {
+        if (root == null) return this;
+
+        Object boxed = box(key);
+        Box removedLeaf = new Box();
+        Node newRoot = root.without(null, 0, boxed.hashCode(), boxed, removedLeaf);
+        if (!removedLeaf.value) return this;
+        return new PersistentHashMap(count - 1, newRoot);
+    }
+
+    public TransientHashMap asTransient() {
+        return new TransientHashMap(this);
+    }
+
+    public void forEach(BiConsumer<Object, Object> action) {
+        if (root != null) root.forEach(action);
+    }
+
+    static Object box(Object key) {
+        return key == null ? NIL_KEY : key;
+    }
+
+    static Object unbox(Object key) {
+        return key == NIL_KEY ? null : key;
+    }
+
+    static int bitpos(int hash, int shift) {
+        return 1 << ((hash >>> shift) & 31);
+    }
+
+    static final class Box {
+        boolean value;
+    }
+
+    interface Node {
+        Object find(int shift, int hash, Object key);
+
+        Node assoc(AtomicReference<Thread> edit, int shift, int hash, Object key, Object value, Box addedLeaf);
+
+        Node without(AtomicReference<Thread> edit, int shift, int hash, Object key, Box removedLeaf);
+
+        void forEach(BiConsumer<Object, Object> action);
+    }
+
+    // Slots hold key/value pairs. A null key marks a slot whose value is a child node.
+    static final class BitmapNode implements Node {
+        static final BitmapNode EMPTY = new BitmapNode(null, 0, new Object[0]);
+
+        final AtomicReference<Thread> edit;
+        int bitmap;
+        Object[] array;
+
+        BitmapNode(AtomicReference<Thread> edit, int bitmap, Object[] array) {
+            this.edit = edit;
+            this.bitmap = bitmap;
+            this.array = array;
+        }
+
+        private int index(int bit) {
+            return Integer.bitCount(bitmap & (bit - 1));
+        }
+
+        @Override
+        public Object find(int shift, int hash, Object key) {
+            int bit = bitpos(hash, shift);
+            if ((bitmap & bit) == 0) return null;
+
+            int index = index(bit);
+            Object keyOrNull = array[2 * index];
+            Object valueOrNode = array[2 * index + 1];
+            if (keyOrNull == null) return ((Node) valueOrNode).find(shift + 5, hash, key);
+            if (key.equals(keyOrNull)) return valueOrNode;
+            return null;
+        }
+
+        @Override
+        public Node assoc(AtomicReference<Thread> edit, int shift, int hash, Object key, Object value, Box addedLeaf) {
+            int bit = bitpos(hash, shift);
+            int index = index(bit);
+
+            if ((bitmap & bit) != 0) {
+                Object keyOrNull = array[2 * index];
+                Object valueOrNode = array[2 * index + 1];
+
+                if (keyOrNull == null) {
+                    Node node = ((Node) valueOrNode).assoc(edit, shift + 5, hash, key, value, addedLeaf);
+                    if (node == valueOrNode) return this;
+                    return editAndSet(edit, 2 * index + 1, node);
+                }
+
+                if (key.equals(keyOrNull)) {
+                    if (value == valueOrNode) return this;
+                    return editAndSet(edit, 2 * index + 1, value);
+                }
+
+                addedLeaf.value = true;
+                Node child = createNode(edit, shift + 5, keyOrNull, valueOrNode, hash, key, value);
+                BitmapNode editable = ensureEditable(edit);
+                editable.array[2 * index] = null;
+                editable.array[2 * index + 1] = child;
+                return editable;
+            }
+
+            int size = Integer.bitCount(bitmap);
+            Object[] newArray = new Object[2 * (size + 1)];
+            System.arraycopy(array, 0, newArray, 0, 2 * index);
+            newArray[2 * index] = key;
+            newArray[2 * index + 1] = value;
+            System.arraycopy(array, 2 * index, newArray, 2 * (index + 1), 2 * (size - index));
+            addedLeaf.value = true;
+
+            if (edit != null && edit == this.edit) {
+                bitmap |= bit;
+                array = newArray;
+                return this;
+            }
+            return new BitmapNode(edit, bitmap | bit, newArray);
+        }
+
+        @Override
+        public Node without(AtomicReference<Thread> edit, int shift, int hash, Object key, Box removedLeaf) {
+            int bit = bitpos(hash, shift);
+            if ((bitmap & bit) == 0) return this;
+
+            int index = index(bit);
+            Object keyOrNull = array[2 * index];
+            Object valueOrNode = array[2 * index + 1];
+
+            if (keyOrNull == null) {
+                Node node = ((Node) valueOrNode).without(edit, shift + 5, hash, key, removedLeaf);
+                if (node == valueOrNode) return this;
+                if (node != null) return editAndSet(edit, 2 * index + 1, node);
+                if (bitmap == bit) return null;
+                return removePair(edit, bit, index);
+            }
+
+            if (key.equals(keyOrNull)) {
+                removedLeaf.value = true;
+                if (bitmap == bit) return null;
+                return removePair(edit, bit, index);
+            }
+
+            return this;
+        }
+
+        @Override
+        public void forEach(BiConsumer<Object, Object> action) {
+            for (int i = 0; i < array.length; i += 2) {
+                if (array[i] == null)
+                    ((Node) array[i + 1]).forEach(action);
+                else
+                    action.accept(unbox(array[i]), array[i + 1]);
+            }
+        }
+
+        private BitmapNode ensureEditable(AtomicReference<Thread> edit) {
+            if (edit != null && edit == this.edit) return this;
+            return new BitmapNode(edit, bitmap, array.clone());
+        }
+
+        private BitmapNode editAndSet(AtomicReference<Thread> edit, int index, Object value) {
+            BitmapNode editable = ensureEditable(edit);
+            editable.array[index] = value;
+            return editable;
+        }
+
+        private BitmapNode removePair(AtomicReference<Thread> edit, int bit, int index) {
+            Object[] newArray = new Object[array.length - 2];
+            System.arraycopy(array, 0, newArray, 0, 2 * index);
+            System.arraycopy(array, 2 * (index + 1), newArray, 2 * index, newArray.length - 2 * index);
+
+            if (edit != null && edit == this.edit) {
+                bitmap ^= bit;
+                array = newArray;
+                return this;
+            }
+            return new BitmapNode(edit, bitmap ^ bit, newArray);
+        }
+    }
+
+    // Holds every key whose full 32-bit hash is identical.
+    static final class CollisionNode implements Node {
+        final AtomicReference<Thread> edit;
+        final int hash;
+        Object[] array;
+
+        CollisionNode(AtomicReference<Thread> edit, int hash, Object[] array) {
+            this.edit = edit;
+            this.hash = hash;
+            this.array = array;
+        }
+
+        private int findIndex(Object key) {
+            for (int i = 0; i < array.length; i += 2) {
+                if (key.equals(array[i])) return i;
+            }
+            return -1;
+        }
+
+        @Override
+        public Object find(int shift, int hash, Object key) {
+            int index = findIndex(key);
+            if (index < 0) return null;
+            return array[index + 1];
+        }
+
+        @Override
+        public Node assoc(AtomicReference<Thread> edit, int shift, int hash, Object key, Object value, Box addedLeaf) {
+            if (hash != this.hash) {
+                BitmapNode parent = new BitmapNode(edit, bitpos(this.hash, shift), new Object[]{null, this});
+                return parent.assoc(edit, shift, hash, key, value, addedLeaf);
+            }
+
+            int index = findIndex(key);
+            if (index >= 0) {
+                if (array[index + 1] == value) return this;
+                CollisionNode editable = ensureEditable(edit, array.clone());
+                editable.array[index + 1] = value;
+                return editable;
+            }
+
+            Object[] newArray = new Object[array.length + 2];
+            System.arraycopy(array, 0, newArray, 0, array.length);
+            newArray[array.length] = key;
+            newArray[array.length + 1] = value;
+            addedLeaf.value = true;
+            return ensureEditable(edit, newArray);
+        }
+
+        @Override
+        public Node without(AtomicReference<Thread> edit, int shift, int hash, Object key, Box removedLeaf) {
+            int index = findIndex(key);
+            if (index < 0) return this;
+
+            removedLeaf.value = true;
+            if (array.length == 2) return null;
+
+            Object[] newArray = new Object[array.length - 2];
+            System.arraycopy(array, 0, newArray, 0, index);
+            System.arraycopy(array, index + 2, newArray, index, newArray.length - index);
+            return ensureEditable(edit, newArray);
+        }
+
+        @Override
+        public void forEach(BiConsumer<Object, Object> action) {
+            for (int i = 0; i < array.length; i += 2)
+                action.accept(unbox(array[i]), array[i + 1]);
+        }
+
+        private CollisionNode ensureEditable(AtomicReference<Thread> edit, Object[] newArray) {
+            if (edit != null && edit == this.edit) {
+                array = newArray;
+                return this;
+            }
+            return new CollisionNode(edit, hash, newArray);
+        }
+    }
+
+    static Node createNode(AtomicReference<Thread> edit, int shift, Object key1, Object value1, int key2Hash, Object key2, Object value2) {
+        int key1Hash = key1.hashCode();
+        if (key1Hash == key2Hash)
+            return new CollisionNode(edit, key1Hash, new Object[]{key1, value1, key2, value2});
+
+        Box addedLeaf = new Box();
+        return BitmapNode.EMPTY
+                .assoc(edit, shift, key1Hash, key1, value1, addedLeaf)
+                .assoc(edit, shift, key2Hash, key2, value2, addedLeaf);
+    }
+
+    @Override
+    public boolean equals(Object other) {
+        if (this == other) return true;
+        if (!(other instanceof PersistentHashMap map) || map.count != count) return false;
+        if (count == 0) return true;
+
+        boolean[] equal = {true};
+        root.forEach((key, value) -> {
+            if (!equal[0]) return;
+            Object boxed = box(key);
+            if (!map.containsBoxed(boxed) || !Objects.equals(value, map.root.find(0, boxed.hashCode(), boxed)))
+                equal[0] = false;
+        });
+        return equal[0];
+    }
+
+    private boolean containsBoxed(Object boxed) {
+        int hash = boxed.hashCode();
+        Node node = root;
+        int shift = 0;
+        while (node instanceof BitmapNode) {
+            BitmapNode bitmapNode = (BitmapNode) node;
+            int bit = bitpos(hash, shift);
+            if ((bitmapNode.bitmap & bit) == 0) return false;
+
+            int index = bitmapNode.index(bit);
+            Object keyOrNull = bitmapNode.array[2 * index];
+            if (keyOrNull != null) return boxed.equals(keyOrNull);
+            node = (Node) bitmapNode.array[2 * index + 1];
+            shift += 5;
+        }
+        return node != null && ((CollisionNode) node).findIndex(boxed) >= 0;
+    }
+
+    @Override
+    public int hashCode() {
+        int[] hash = {0};
+        forEach((key, value) -> hash[0] += (key == null ? 0 : key.hashCode()) ^ (value == null ? 0 : value.hashCode()));
+        return hash[0];
+    }
+
+    @Override
+    public String toString() {
+        StringBuilder builder = new StringBuilder("{");
+        forEach((key, value) -> {
+            if (builder.length() > 1) builder.append(", ");
+            builder.append(Interpreter.stringify(key)).append(": ").append(Interpreter.stringify(value));
+        });
+        return builder.append('}').toString();
+    }
+}
@@ -0,0 +1,195 @@
+package com.aidan.cmel.collections;
+
+import com.aidan.cmel.CmelIndexable;
+import com.aidan.cmel.Interpreter;
+import com.aidan.cmel.RuntimeError;
+
+import java.util.Arrays;
+import java.util.concurrent.atomic.AtomicReference;
+
+// A 32-way bit-partitioned trie with a tail buffer. Updates copy only the path
+// from the root to the changed leaf, so every version shares the rest of its
+// structure with the versions it was derived from.
+public final class PersistentVector implements CmelIndexable {
+    static final int BITS = 5;
+    static final int WIDTH = 1 << BITS;
+    static final int MASK = WIDTH - 1;
+
+    static final class Node {
+        final AtomicReference<Thread> edit;
+        final Object[] array;
+
+        Node(AtomicReference<Thread> edit) {
+            this(edit, new Object[WIDTH]);
+        }
+
+        Node(AtomicReference<Thread> edit, Object[] array) {
+            this.edit = edit;
+            this.array = array;
+        }
+    }
+
+    private static final Node EMPTY_NODE = new Node(new AtomicReference<>(null));
+    public static final PersistentVector EMPTY = new PersistentVector(0, BITS, EMPTY_NODE, new Object[0]);
+
+    final int count;
+    final int shift;
+    final Node root;
+    final Object[] tail;
+
+    PersistentVector(int count, int shift, Node root, Object[] tail) {
+        this.count = count;
+        this.shift = shift;
+        this.root = root;
+        this.tail = tail;
+    }
+
+    public int count() {
+        return count;
+    }
+
+    public Object nth(int index) {
+        return arrayFor(index)[index & MASK];
+    }
+
+    public PersistentVector assocN(int index, Object value) {
+        if (index == count) return conj(value);
+
+        if (index >= tailOffset()) {
+            Object[] newTail = tail.clone();
+            newTail[index & MASK] = value;
+            return new PersistentVector(count, shift, root, newTail);
+        }
+
+        return new PersistentVector(count, shift, doAssoc(shift, root, index, value), tail);
+    }
+
+    public PersistentVector conj(Object value) {
+        if (count - tailOffset() < WIDTH) {
+            Object[] newTail = Arrays.copyOf(tail, tail.length + 1);
+            newTail[tail.length] = value;
+            return new PersistentVector(count + 1, shift, root, newTail);
+        }
+
+        Node tailNode = new Node(root.edit, tail);
+        Node newRoot;
+        int newShift = shift;
+        if ((count >>> BITS) > (1 << shift)) {
+            newRoot = new Node(root.edit);
+            newRoot.array[0] = root;
+            newRoot.array[1] = newPath(root.edit, shift, tailNode);
+            newShift += BITS;
+        } else {
+            newRoot = pushTail(shift, root, tailNode);
+        }
+
+        return new PersistentVector(count + 1, newShift, newRoot, new Object[]{value});
+    }
+
+    @Override
+    public Object get(Object index) {
+        return nth(CmelIndexable.toIndex(index, count));
+    }
+
+    @Override
+    public void set(Object index, Object value) {
+        throw new RuntimeError("Can't assign into a persistent vector; use assoc.");
+    }
+
+    @Override
+    public int length() {
+        return count;
+    }
+
+    public TransientVector asTransient() {
+        return new TransientVector(this);
+    }
+
+    int tailOffset() {
+        return tailOffset(count);
+    }
+
+    static int tailOffset(int count) {
+        if (count < WIDTH) return 0;
+        return ((count - 1) >>> BITS) << BITS;
+    }
+
+    private Object[] arrayFor(int index) {
+        if (index >= tailOffset()) return tail;
+
+        Node node = root;
+        for (int level = shift; level > 0; level -= BITS)
+            node = (Node) node.array[(index >>> level) & MASK];
+        return node.array;
+    }
+
+    private Node pushTail(int level, Node parent, Node tailNode) {
+        int subIndex = ((count - 1) >>> level) & MASK;
+        Node result = new Node(parent.edit, parent.array.clone());
+
+        Node toInsert;
+        if (level == BITS) {
+            toInsert = tailNode;
+        } else {
+            Node child = (Node) parent.array[subIndex];
+            toInsert = child != null
+                    ? pushTail(level - BITS, child, tailNode)
+                    : newPath(root.edit, level - BITS, tailNode);
+        }
+
+        result.array[subIndex] = toInsert;
+        return result;
+    }
+
+    private static Node doAssoc(int level, Node node, int index, Object value) {
+        Node result = new Node(node.edit, node.array.clone());
+        if (level == 0) {
+            result.array[index & MASK] = value;
+        } else {
+            int subIndex = (index >>> level) & MASK;
+            result.array[subIndex] = doAssoc(level - BITS, (Node) node.array[subIndex], index, value);
+        }
+        return result;
+    }
+
+    static Node newPath(AtomicReference<Thread> edit, int level, Node node) {
+        if (level == 0) return node;
+
+        Node result = new Node(edit);
+        result.array[0] = newPath(edit, level - BITS, node);
+        return result;
+    }
+
+    @Override
+    public boolean equals(Object other) {
+        if (this == other) return true;
+        if (!(other instanceof PersistentVector vector) || vector.count != count) return false;
+
+        for (int i = 0; i < count; i++) {
+            Object left = nth(i);
+            Object right = vector.nth(i);
+            if (left == null ? right != null : !left.equals(right)) return false;
+        }
+        return true;
+    }
+
+    @Override
+    public int hashCode() {
+        int hash = 1;
+        for (int i = 0; i < count; i++) {
+            Object element = nth(i);
+            hash = 31 * hash + (element == null ? 0 : element.hashCode());
+        }
+        return hash;
+    }
+
+    @Override
+    public String toString() {
+        StringBuilder builder = new StringBuilder("[");
+        for (int i = 0; i < count; i++) {
+            if (i > 0) builder.append(", ");
+            builder.append(Interpreter.stringify(nth(i)));
+        }
+        return builder.append(']').toString();
+    }
+}
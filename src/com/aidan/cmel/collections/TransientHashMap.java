@@ -0,0 +1,81 @@
+package com.aidan.cmel.collections;
+
+import com.aidan.cmel.CmelIndexable;
+import com.aidan.cmel.RuntimeError;
+
+import java.util.concurrent.atomic.AtomicReference;
+
+public final class TransientHashMap implements CmelIndexable {
+    private final AtomicReference<Thread> edit;
+    private int count;
+    private PersistentHashMap.Node root;
+
+    TransientHashMap(PersistentHashMap map) {
+        this.edit = new AtomicReference<>(Thread.currentThread());
+        this.count = map.count;
+        this.root = map.root;
+    }
+
+    public int count() {
+        ensureEditable();
+        return count;
+    }
+
+    @Override
+    public Object get(Object key) {
+        ensureEditable();
+        if (root == null) return null;
+        Object boxed = PersistentHashMap.box(key);
+        return root.find(0, boxed.hashCode(), boxed);
+    }
+
+    public TransientHashMap assoc(Object key, Object value) {
+        ensureEditable();
+        Object boxed = PersistentHashMap.box(key);
+        PersistentHashMap.Box addedLeaf = new PersistentHashMap.Box();
+        PersistentHashMap.Node start = root == null ? PersistentHashMap.BitmapNode.EMPTY : root;
+        root = start.assoc(edit, 0, boxed.hashCode(), boxed, value, addedLeaf);
+        if (addedLeaf.value) count++;
+        return this;
+    }
+
+    @Override
+    public void set(Object key, Object value) {
+        assoc(key, value);
+    }
+
+    @Override
+    public int length() {
+        return count();
+    }
+
+    public TransientHashMap without(Object key) {
+        ensureEditable();
+        if (root == null) return this;
+
+        Object boxed = PersistentHashMap.box(key);
+        PersistentHashMap.Box removedLeaf = new PersistentHashMap.Box();
+        root = root.without(edit, 0, boxed.hashCode(), boxed, removedLeaf);
+        if (removedLeaf.value) count--;
+        return this;
+    }
+
+    public PersistentHashMap persistent() {
+        ensureEditable();
+        edit.set(null);
+        return new PersistentHashMap(count, root);
+    }
+
+    private void ensureEditable() {
+        Thread owner = edit.get();
+        if (owner == null)
+            throw new RuntimeError("Transient used after it was made persistent.");
+        if (owner != Thread.currentThread())
+            throw new RuntimeError("Transient used by a thread that does not own it.");
+    }
+
+    @Override
+    public String toString() {
+        return "<transient map>";
+    }
+}
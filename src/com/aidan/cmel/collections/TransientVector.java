@@ -0,0 +1,157 @@
+package com.aidan.cmel.collections;
+
+import com.aidan.cmel.CmelIndexable;
+import com.aidan.cmel.RuntimeError;
+
+import java.util.concurrent.atomic.AtomicReference;
+
+import static com.aidan.cmel.collections.PersistentVector.BITS;
+import static com.aidan.cmel.collections.PersistentVector.MASK;
+import static com.aidan.cmel.collections.PersistentVector.WIDTH;
+
+// Nodes stamped with this transient's edit token are owned by it and are
+// updated in place; anything still shared with a persistent version is copied
+// the first time it is touched.
+public final class TransientVector implements CmelIndexable {
+    private int count;
+    private int shift;
+    private PersistentVector.Node root;
+    private Object[] tail;
+
+    TransientVector(PersistentVector vector) {
+        this.count = vector.count;
+        this.shift = vector.shift;
+        this.root = new PersistentVector.Node(new AtomicReference<>(Thread.currentThread()), vector.root.array.clone());
+        this.tail = new Object[WIDTH];
+        System.arraycopy(vector.tail, 0, tail, 0, vector.tail.length);
+    }
+
+    public int count() {
+        ensureEditable();
+        return count;
+    }
+
+    public Object nth(int index) {
+        ensureEditable();
+        return arrayFor(index)[index & MASK];
+    }
+
+    public TransientVector assocN(int index, Object value) {
+        ensureEditable();
+        if (index == count) return conj(value);
+
+        if (index >= PersistentVector.tailOffset(count)) {
+            tail[index & MASK] = value;
+            return this;
+        }
+
+        root = doAssoc(shift, root, index, value);
+        return this;
+    }
+
+    public TransientVector conj(Object value) {
+        ensureEditable();
+        if (count - PersistentVector.tailOffset(count) < WIDTH) {
+            tail[count & MASK] = value;
+            count++;
+            return this;
+        }
+
+        PersistentVector.Node tailNode = new PersistentVector.Node(root.edit, tail);
+        tail = new Object[WIDTH];
+        tail[0] = value;
+
+        if ((count >>> BITS) > (1 << shift)) {
+            PersistentVector.Node newRoot = new PersistentVector.Node(root.edit);
+            newRoot.array[0] = root;
+            newRoot.array[1] = PersistentVector.newPath(root.edit, shift, tailNode);
+            root = newRoot;
+            shift += BITS;
+        } else {
+            root = pushTail(shift, root, tailNode);
+        }
+
+        count++;
+        return this;
+    }
+
+    @Override
+    public Object get(Object index) {
+        return nth(CmelIndexable.toIndex(index, count()));
+    }
+
+    @Override
+    public void set(Object index, Object value) {
+        assocN(CmelIndexable.toIndex(index, count() + 1), value);
+    }
+
+    @Override
+    public int length() {
+        return count();
+    }
+
+    public PersistentVector persistent() {
+        ensureEditable();
+        root.edit.set(null);
+
+        Object[] trimmedTail = new Object[count - PersistentVector.tailOffset(count)];
+        System.arraycopy(tail, 0, trimmedTail, 0, trimmedTail.length);
+        return new PersistentVector(count, shift, root, trimmedTail);
+    }
+
+    private void ensureEditable() {
+        Thread owner = root.edit.get();
+        if (owner == null)
+            throw new RuntimeError("Transient used after it was made persistent.");
+        if (owner != Thread.currentThread())
+            throw new RuntimeError("Transient used by a thread that does not own it.");
+    }
+
+    private PersistentVector.Node ensureEditable(PersistentVector.Node node) {
+        if (node.edit == root.edit) return node;
+        return new PersistentVector.Node(root.edit, node.array.clone());
+    }
+
+    private Object[] arrayFor(int index) {
+        if (index >= PersistentVector.tailOffset(count)) return tail;
+
+        PersistentVector.Node node = root;
+        for (int level = shift; level > 0; level -= BITS)
+            node = (PersistentVector.Node) node.array[(index >>> level) & MASK];
+        return node.array;
+    }
+
+    private PersistentVector.Node pushTail(int level, PersistentVector.Node parent, PersistentVector.Node tailNode) {
+        PersistentVector.Node result = ensureEditable(parent);
+        int subIndex = ((count - 1) >>> level) & MASK;
+
+        PersistentVector.Node toInsert;
+        if (level == BITS) {
+            toInsert = tailNode;
+        } else {
+            PersistentVector.Node child = (PersistentVector.Node) result.array[subIndex];
+            toInsert = child != null
+                    ? pushTail(level - BITS, child, tailNode)
+                    : PersistentVector.newPath(root.edit, level - BITS, tailNode);
+        }
+
+        result.array[subIndex] = toInsert;
+        return result;
+    }
+
+    private PersistentVector.Node doAssoc(int level, PersistentVector.Node node, int index, Object value) {
+        PersistentVector.Node result = ensureEditable(node);
+        if (level == 0) {
+            result.array[index & MASK] = value;
+        } else {
+            int subIndex = (index >>> level) & MASK;
+            result.array[subIndex] = doAssoc(level - BITS, (PersistentVector.Node) result.array[subIndex], index, value);
+        }
+        return result;
+    }
+
+    @Override
+    public String toString() {
+        return "<transient vector>";
+    }
+}
@@ -0,0 +1,87 @@
+package com.aidan.cmel.collections;
+
+import com.aidan.cmel.CmelIndexable;
+import com.aidan.cmel.RuntimeError;
+
+import java.lang.ref.ReferenceQueue;
+import java.lang.ref.WeakReference;
+import java.util.HashMap;
+import java.util.Map;
+
+// A mutable map whose keys are held weakly and compared by identity, for
+// caches keyed by instances: once nothing else refers to a key its entry
+// goes. Collected keys are queued by the collector, and every operation first
+// removes their entries, so dead entries never outlive the next use of the
+// map. Values are held strongly; a value that refers to its own key keeps the
+// entry alive. Since even a read changes the map, every operation holds its
+// lock, so iterations of a parallel for can share one.
+public final class WeakMap implements CmelIndexable {
+    private final Map<Key, Object> entries = new HashMap<>();
+    private final ReferenceQueue<Object> collected = new ReferenceQueue<>();
+
+    private static final class Key extends WeakReference<Object> {
+        final int hash;
+
+        Key(Object referent, ReferenceQueue<Object> queue) {
+            super(referent, queue);
+            hash = System.identityHashCode(referent);
+        }
+
+        @Override
+        public int hashCode() {
+            return hash;
+        }
+
+        // A collected key is only equal to itself, so expunging finds it.
+        @Override
+        public boolean equals(Object other) {
+            if (this == other) return true;
+            if (!(other instanceof Key key)) return false;
+            Object referent = get();
+            return referent != null && referent == key.get();
+        }
+    }
+
+    @Override
+    public synchronized Object get(Object key) {
+        expunge();
+        if (!isReference(key)) return null;
+        return entries.get(lookup(key));
+    }
+
+    // Storing nil removes the entry.
+    @Override
+    public synchronized void set(Object key, Object value) {
+        expunge();
+        if (!isReference(key))
+            throw new RuntimeError("Weak map keys must be objects, not numbers, strings, booleans or nil.");
+        if (value == null) entries.remove(lookup(key));
+        else entries.put(new Key(key, collected), value);
+    }
+
+    @Override
+    public synchronized int length() {
+        expunge();
+        return entries.size();
+    }
+
+    private Key lookup(Object key) {
+        return new Key(key, null);
+    }
+
+    private void expunge() {
+        for (Object key; (key = collected.poll()) != null; )
+            entries.remove(key);
+    }
+
+    // Values with no identity of their own would be collected straight away,
+    // or never.
+    private static boolean isReference(Object key) {
+        return key != null && !(key instanceof Double) && !(key instanceof String) && !(key instanceof Boolean);
+    }
+
+    @Override
+    public String toString() {
+        return "<weak map>";
+    }
+}
@@ -0,0 +1,22 @@
+package com.aidan.cmel.collections;
+
+import java.lang.ref.WeakReference;
+
+// A reference that doesn't keep its object alive. deref answers nil once the
+// object has been collected.
+public final class WeakRef {
+    private final WeakReference<Object> reference;
+
+    public WeakRef(Object referent) {
+        reference = new WeakReference<>(referent);
+    }
+
+    public Object deref() {
+        return reference.get();
+    }
+
+    @Override
+    public String toString() {
+        return "<weak ref>";
+    }
+}
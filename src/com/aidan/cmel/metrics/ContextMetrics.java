@@ -0,0 +1,111 @@
+package com.aidan.cmel.metrics;
+
+import java.util.concurrent.atomic.LongAdder;
+
+// The counters for every interpreter created under one context name. They are
+// LongAdders, which spread concurrent updates over per-thread cells and only
+// add them up when read, so interpreters on many threads can count calls
+// without contending.
+public final class ContextMetrics implements ContextMetricsMBean {
+    private final String name;
+    private final LongAdder scriptsRun = new LongAdder();
+    private final LongAdder runtimeErrors = new LongAdder();
+    private final LongAdder calls = new LongAdder();
+    private final LongAdder allocations = new LongAdder();
+    private final LongAdder cacheHits = new LongAdder();
+    private final LongAdder cacheMisses = new LongAdder();
+    private final LongAdder active = new LongAdder();
+    private final Histogram executionTime = new Histogram();
+
+    ContextMetrics(String name) {
+        this.name = name;
+    }
+
+    public String name() {
+        return name;
+    }
+
+    // Answers the start time to hand to scriptFinished.
+    public long scriptStarted() {
+        active.increment();
+        return System.nanoTime();
+    }
+
+    public void scriptFinished(long start) {
+        executionTime.observe(System.nanoTime() - start);
+        scriptsRun.increment();
+        active.decrement();
+    }
+
+    public void runtimeError() {
+        runtimeErrors.increment();
+    }
+
+    public void call() {
+        calls.increment();
+    }
+
+    public void allocation() {
+        allocations.increment();
+    }
+
+    public void cacheHit() {
+        cacheHits.increment();
+    }
+
+    public void cacheMiss() {
+        cacheMisses.increment();
+    }
+
+    Histogram executionTime() {
+        return executionTime;
+    }
+
+    @Override
+    public long getScriptsRun() {
+        return scriptsRun.sum();
+    }
+
+    @Override
+    public long getRuntimeErrors() {
+        return runtimeErrors.sum();
+    }
+
+    @Override
+    public long getCalls() {
+        return calls.sum();
+    }
+
+    @Override
+    public long getAllocations() {
+        return allocations.sum();
+    }
+
+    @Override
+    public long getCallSiteCacheHits() {
+        return cacheHits.sum();
+    }
+
+    @Override
+    public long getCallSiteCacheMisses() {
+        return cacheMisses.sum();
+    }
+
+    @Override
+    public double getCallSiteCacheHitRate() {
+        long hits = cacheHits.sum();
+        long total = hits + cacheMisses.sum();
+        return total == 0 ? 0 : (double) hits / total;
+    }
+
+    @Override
+    public long getActiveInterpreters() {
+        return active.sum();
+    }
+
+    @Override
+    public double getMeanExecutionMillis() {
+        long count = executionTime.count();
+        return count == 0 ? 0 : executionTime.sum() * 1000 / count;
+    }
+}
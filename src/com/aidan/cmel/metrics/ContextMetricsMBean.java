@@ -0,0 +1,21 @@
+package com.aidan.cmel.metrics;
+
+public interface ContextMetricsMBean {
+    long getScriptsRun();
+
+    long getRuntimeErrors();
+
+    long getCalls();
+
+    long getAllocations();
+
+    long getCallSiteCacheHits();
+
+    long getCallSiteCacheMisses();
+
+    double getCallSiteCacheHitRate();
+
+    long getActiveInterpreters();
+
+    double getMeanExecutionMillis();
+}
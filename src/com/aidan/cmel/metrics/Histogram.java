@@ -0,0 +1,43 @@
+package com.aidan.cmel.metrics;
+
+import java.util.concurrent.atomic.DoubleAdder;
+import java.util.concurrent.atomic.LongAdder;
+
+// A histogram of durations with fixed buckets, each a LongAdder, so threads
+// recording at once rarely touch the same cache line.
+public final class Histogram {
+    // Upper bounds in seconds, with an implicit +Inf bucket after the last.
+    static final double[] BOUNDS = {0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10};
+
+    private final LongAdder[] buckets = new LongAdder[BOUNDS.length + 1];
+    private final DoubleAdder sum = new DoubleAdder();
+
+    Histogram() {
+        for (int i = 0; i < buckets.length; i++) buckets[i] = new LongAdder();
+    }
+
+    public void observe(long nanos) {
+        double seconds = nanos / 1e9;
+        int bucket = 0;
+        while (bucket < BOUNDS.length && seconds > BOUNDS[bucket]) bucket++;
+        buckets[bucket].increment();
+        sum.add(seconds);
+    }
+
+    // Counts per bucket, not yet cumulative.
+    long[] counts() {
+        long[] counts = new long[buckets.length];
+        for (int i = 0; i < counts.length; i++) counts[i] = buckets[i].sum();
+        return counts;
+    }
+
+    long count() {
+        long count = 0;
+        for (LongAdder bucket : buckets) count += bucket.sum();
+        return count;
+    }
+
+    double sum() {
+        return sum.sum();
+    }
+}
@@ -0,0 +1,59 @@
+package com.aidan.cmel.metrics;
+
+import javax.management.JMException;
+import javax.management.ObjectName;
+import java.io.IOException;
+import java.lang.management.ManagementFactory;
+import java.util.Collection;
+import java.util.concurrent.ConcurrentHashMap;
+import java.util.concurrent.ConcurrentMap;
+
+// Every context's metrics, each registered as an MBean named
+// com.aidan.cmel:type=Interpreter,context=<name>. Setting the cmel.metrics.port
+// system property also serves them all in the Prometheus text format on that
+// local port.
+public final class Metrics {
+    private static final ConcurrentMap<String, ContextMetrics> contexts = new ConcurrentHashMap<>();
+    private static PrometheusExporter exporter;
+
+    static {
+        String port = System.getProperty("cmel.metrics.port");
+        if (port != null) {
+            try {
+                exporter = PrometheusExporter.start(Integer.parseInt(port));
+            } catch (IOException | NumberFormatException e) {
+                System.err.println("Couldn't serve metrics on port " + port + ": " + e.getMessage());
+            }
+        }
+    }
+
+    private Metrics() {}
+
+    public static ContextMetrics context(String name) {
+        return contexts.computeIfAbsent(name, Metrics::register);
+    }
+
+    static Collection<ContextMetrics> contexts() {
+        return contexts.values();
+    }
+
+    private static ContextMetrics register(String name) {
+        ContextMetrics metrics = new ContextMetrics(name);
+        try {
+            ObjectName objectName = new ObjectName("com.aidan.cmel:type=Interpreter,context=" + ObjectName.quote(name));
+            ManagementFactory.getPlatformMBeanServer().registerMBean(metrics, objectName);
+        } catch (JMException e) {
+            // The counters still work without JMX.
+            System.err.println("Couldn't register metrics for context " + name + ": " + e.getMessage());
+        }
+        return metrics;
+    }
+
+    // Starts serving on the given local port, in place of any exporter
+    // started before.
+    public static synchronized PrometheusExporter serve(int port) throws IOException {
+        if (exporter != null) exporter.close();
+        exporter = PrometheusExporter.start(port);
+        return exporter;
+    }
+}
@@ -0,0 +1,119 @@
+package com.aidan.cmel.metrics;
+
+import com.sun.net.httpserver.HttpExchange;
+import com.sun.net.httpserver.HttpServer;
+
+import java.io.IOException;
+import java.io.OutputStream;
+import java.net.InetAddress;
+import java.net.InetSocketAddress;
+import java.nio.charset.StandardCharsets;
+import java.util.ArrayList;
+import java.util.Comparator;
+import java.util.List;
+
+// Serves GET /metrics in the Prometheus text exposition format, on the
+// loopback interface only.
+public final class PrometheusExporter implements AutoCloseable {
+    private final HttpServer server;
+
+    private PrometheusExporter(HttpServer server) {
+        this.server = server;
+    }
+
+    static PrometheusExporter start(int port) throws IOException {
+        HttpServer server = HttpServer.create(new InetSocketAddress(InetAddress.getLoopbackAddress(), port), 0);
+        server.createContext("/metrics", PrometheusExporter::handle);
+
+        // The server's dispatcher thread takes its daemon status from the
+        // thread that starts it, and mustn't keep a finished script's JVM
+        // alive.
+        Thread starter = new Thread(server::start, "cmel-metrics");
+        starter.setDaemon(true);
+        starter.start();
+        try {
+            starter.join();
+        } catch (InterruptedException e) {
+            Thread.currentThread().interrupt();
+        }
+        return new PrometheusExporter(server);
+    }
+
+    public int port() {
+        return server.getAddress().getPort();
+    }
+
+    @Override
+    public void close() {
+        server.stop(0);
+    }
+
+    private static void handle(HttpExchange exchange) throws IOException {
+        try {
+            if (!exchange.getRequestMethod().equals("GET")) {
+                exchange.sendResponseHeaders(405, -1);
+                return;
+            }
+            byte[] body = render().getBytes(StandardCharsets.UTF_8);
+            exchange.getResponseHeaders().set("Content-Type", "text/plain; version=0.0.4; charset=utf-8");
+            exchange.sendResponseHeaders(200, body.length);
+            try (OutputStream out = exchange.getResponseBody()) {
+                out.write(body);
+            }
+        } finally {
+            exchange.close();
+        }
+    }
+
+    static String render() {
+        List<ContextMetrics> contexts = new ArrayList<>(Metrics.contexts());
+        contexts.sort(Comparator.comparing(ContextMetrics::name));
+        StringBuilder text = new StringBuilder();
+
+        counter(text, contexts, "cmel_scripts_run_total", "Scripts run to completion or error.", ContextMetrics::getScriptsRun);
+        counter(text, contexts, "cmel_runtime_errors_total", "Scripts stopped by a runtime error.", ContextMetrics::getRuntimeErrors);
+        counter(text, contexts, "cmel_calls_total", "Function, method, class and native calls.", ContextMetrics::getCalls);
+        counter(text, contexts, "cmel_allocations_total", "Instances and arrays created.", ContextMetrics::getAllocations);
+        counter(text, contexts, "cmel_call_site_cache_hits_total", "Calls whose site had already cached the callee.", ContextMetrics::getCallSiteCacheHits);
+        counter(text, contexts, "cmel_call_site_cache_misses_total", "Calls whose site had to look up the callee.", ContextMetrics::getCallSiteCacheMisses);
+
+        text.append("# HELP cmel_active_interpreters Interpreters running a script now.\n");
+        text.append("# TYPE cmel_active_interpreters gauge\n");
+        for (ContextMetrics context : contexts)
+            text.append("cmel_active_interpreters").append(labels(context, null)).append(' ').append(context.getActiveInterpreters()).append('\n');
+
+        text.append("# HELP cmel_execution_seconds Time taken to run each script.\n");
+        text.append("# TYPE cmel_execution_seconds histogram\n");
+        for (ContextMetrics context : contexts) {
+            Histogram histogram = context.executionTime();
+            long[] counts = histogram.counts();
+            long cumulative = 0;
+            for (int i = 0; i < counts.length; i++) {
+                cumulative += counts[i];
+                String bound = i < Histogram.BOUNDS.length ? Double.toString(Histogram.BOUNDS[i]) : "+Inf";
+                text.append("cmel_execution_seconds_bucket").append(labels(context, bound)).append(' ').append(cumulative).append('\n');
+            }
+            text.append("cmel_execution_seconds_sum").append(labels(context, null)).append(' ').append(histogram.sum()).append('\n');
+            text.append("cmel_execution_seconds_count").append(labels(context, null)).append(' ').append(cumulative).append('\n');
+        }
+        return text.toString();
+    }
+
+    private interface Reading {
+        long read(ContextMetrics context);
+    }
+
+    private static void counter(StringBuilder text, List<ContextMetrics> contexts, String name, String help, Reading reading) {
+        text.append("# HELP ").append(name).append(' ').append(help).append('\n');
+        text.append("# TYPE ").append(name).append(" counter\n");
+        for (ContextMetrics context : contexts)
+            text.append(name).append(labels(context, null)).append(' ').append(reading.read(context)).append('\n');
+    }
+
+    private static String labels(ContextMetrics context, String bucket) {
+        String name = context.name().replace("\\", "\\\\").replace("\"", "\\\"").replace("\n", "\\n");
+        String labels = "{context=\"" + name + "\"";
+        if (bucket != null) labels += ",le=\"" + bucket + "\"";
+        return labels + "}";
+    }
+}
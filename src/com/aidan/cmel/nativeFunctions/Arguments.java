@@ -0,0 +1,51 @@
+package com.aidan.cmel.nativeFunctions;
+
+import com.aidan.cmel.CmelArray;
+import com.aidan.cmel.CmelIndexable;
+import com.aidan.cmel.CmelOffHeapArray;
+import com.aidan.cmel.CmelTypedArray;
+import com.aidan.cmel.RuntimeError;
+import com.aidan.cmel.collections.ConcurrentMap;
+import com.aidan.cmel.collections.TransientHashMap;
+import com.aidan.cmel.collections.TransientVector;
+import com.aidan.cmel.store.KeyValueStore;
+
+class Arguments {
+    static int index(Object value) {
+        if (value instanceof Double number && number == Math.floor(number)
+                && number >= Integer.MIN_VALUE && number <= Integer.MAX_VALUE)
+            return number.intValue();
+
+        throw new RuntimeError("Index must be a whole number.");
+    }
+
+    static void checkBounds(int index, int count) {
+        if (index < 0 || index >= count)
+            throw new RuntimeError("Index " + index + " is out of bounds for length " + count + ".");
+    }
+
+    static CmelIndexable array(Object value) {
+        if (value instanceof CmelTypedArray || value instanceof CmelArray || value instanceof CmelOffHeapArray)
+            return (CmelIndexable) value;
+        throw new RuntimeError("Expected an array.");
+    }
+
+    static boolean isTransient(Object value) {
+        return value instanceof TransientHashMap || value instanceof TransientVector;
+    }
+
+    static ConcurrentMap concurrentMap(Object value) {
+        if (value instanceof ConcurrentMap map) return map;
+        throw new RuntimeError("Expected a concurrent map.");
+    }
+
+    static KeyValueStore store(Object value) {
+        if (value instanceof KeyValueStore store) return store;
+        throw new RuntimeError("Expected a store.");
+    }
+
+    static String key(Object value) {
+        if (value instanceof String key) return key;
+        throw new RuntimeError("Store keys must be strings.");
+    }
+}
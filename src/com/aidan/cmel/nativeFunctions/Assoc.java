@@ -0,0 +1,53 @@
+package com.aidan.cmel.nativeFunctions;
+
+import com.aidan.cmel.CmelCallable;
+import com.aidan.cmel.Effect;
+import com.aidan.cmel.Interpreter;
+import com.aidan.cmel.RuntimeError;
+import com.aidan.cmel.collections.PersistentHashMap;
+import com.aidan.cmel.collections.PersistentVector;
+import com.aidan.cmel.collections.TransientHashMap;
+import com.aidan.cmel.collections.TransientVector;
+
+import java.util.List;
+
+public class Assoc implements CmelCallable {
+    @Override
+    public Object call(Interpreter interpreter, List<Object> arguments) {
+        Object collection = arguments.get(0);
+        Object key = arguments.get(1);
+        Object value = arguments.get(2);
+
+        if (collection instanceof PersistentHashMap map) return map.assoc(key, value);
+        if (collection instanceof TransientHashMap map) return map.assoc(key, value);
+
+        if (collection instanceof PersistentVector vector) {
+            int index = Arguments.index(key);
+            Arguments.checkBounds(index, vector.count() + 1);
+            return vector.assocN(index, value);
+        }
+        if (collection instanceof TransientVector vector) {
+            int index = Arguments.index(key);
+            Arguments.checkBounds(index, vector.count() + 1);
+            return vector.assocN(index, value);
+        }
+
+        throw new RuntimeError("Can only assoc into vectors and maps.");
+    }
+
+    // Assoc into a transient changes it in place.
+    @Override
+    public Effect effect(List<Object> arguments) {
+        return Arguments.isTransient(arguments.get(0)) ? Effect.WRITES : Effect.PURE;
+    }
+
+    @Override
+    public int arity() {
+        return 3;
+    }
+
+    @Override
+    public String toString() {
+        return "<native fn>";
+    }
+}
@@ -0,0 +1,35 @@
+package com.aidan.cmel.nativeFunctions;
+
+import com.aidan.cmel.CmelCallable;
+import com.aidan.cmel.Effect;
+import com.aidan.cmel.Interpreter;
+import com.aidan.cmel.RuntimeError;
+import com.aidan.cmel.WorkerPool;
+
+import java.util.List;
+
+public class CloseWorkers implements CmelCallable {
+    @Override
+    public Object call(Interpreter interpreter, List<Object> arguments) {
+        if (!(arguments.get(0) instanceof WorkerPool pool))
+            throw new RuntimeError("Expected a worker pool.");
+
+        pool.close();
+        return null;
+    }
+
+    @Override
+    public int arity() {
+        return 1;
+    }
+
+    @Override
+    public Effect effect() {
+        return Effect.IO;
+    }
+
+    @Override
+    public String toString() {
+        return "<native fn>";
+    }
+}
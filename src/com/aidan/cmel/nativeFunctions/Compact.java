@@ -0,0 +1,30 @@
+package com.aidan.cmel.nativeFunctions;
+
+import com.aidan.cmel.CmelCallable;
+import com.aidan.cmel.Effect;
+import com.aidan.cmel.Interpreter;
+
+import java.util.List;
+
+public class Compact implements CmelCallable {
+    @Override
+    public Object call(Interpreter interpreter, List<Object> arguments) {
+        Arguments.store(arguments.get(0)).compact();
+        return null;
+    }
+
+    @Override
+    public int arity() {
+        return 1;
+    }
+
+    @Override
+    public Effect effect() {
+        return Effect.IO;
+    }
+
+    @Override
+    public String toString() {
+        return "<native fn>";
+    }
+}
@@ -0,0 +1,36 @@
+package com.aidan.cmel.nativeFunctions;
+
+import com.aidan.cmel.CmelCallable;
+import com.aidan.cmel.Effect;
+import com.aidan.cmel.Interpreter;
+import com.aidan.cmel.RuntimeError;
+
+import java.util.List;
+
+// computeIfAbsent(map, key, fun (key) { ... }) answers the value under key,
+// calling the function to make it only if no other caller has, or is.
+public class ComputeIfAbsent implements CmelCallable {
+    @Override
+    public Object call(Interpreter interpreter, List<Object> arguments) {
+        if (!(arguments.get(2) instanceof CmelCallable function) || function.arity() != 1)
+            throw new RuntimeError("Expected a function of one argument.");
+
+        return Arguments.concurrentMap(arguments.get(0)).computeIfAbsent(interpreter, arguments.get(1), function);
+    }
+
+    @Override
+    public int arity() {
+        return 3;
+    }
+
+    // It runs whatever function it is given.
+    @Override
+    public Effect effect() {
+        return Effect.IO;
+    }
+
+    @Override
+    public String toString() {
+        return "<native fn>";
+    }
+}
@@ -0,0 +1,53 @@
+package com.aidan.cmel.nativeFunctions;
+
+import com.aidan.cmel.CmelCallable;
+import com.aidan.cmel.CmelIndexable;
+import com.aidan.cmel.CmelTypedArray;
+import com.aidan.cmel.Effect;
+import com.aidan.cmel.Interpreter;
+import com.aidan.cmel.RuntimeError;
+
+import java.util.List;
+
+// copy(source, start, target, targetStart, count) copies count elements from
+// source into target, which may be the same array, and answers target.
+public class Copy implements CmelCallable {
+    @Override
+    public Object call(Interpreter interpreter, List<Object> arguments) {
+        CmelIndexable source = Arguments.array(arguments.get(0));
+        int start = Arguments.index(arguments.get(1));
+        CmelIndexable target = Arguments.array(arguments.get(2));
+        int targetStart = Arguments.index(arguments.get(3));
+        int count = Arguments.index(arguments.get(4));
+
+        if (count < 0 || start < 0 || targetStart < 0
+                || start > source.length() - count || targetStart > target.length() - count)
+            throw new RuntimeError("Copy range is out of bounds.");
+
+        if (source instanceof CmelTypedArray from && target instanceof CmelTypedArray to) {
+            from.copy(start, to, targetStart, count);
+        } else if (source == target && start < targetStart) {
+            for (int i = count - 1; i >= 0; i--)
+                target.set((double) (targetStart + i), source.get((double) (start + i)));
+        } else {
+            for (int i = 0; i < count; i++)
+                target.set((double) (targetStart + i), source.get((double) (start + i)));
+        }
+        return target;
+    }
+
+    @Override
+    public int arity() {
+        return 5;
+    }
+
+    @Override
+    public Effect effect() {
+        return Effect.WRITES;
+    }
+
+    @Override
+    public String toString() {
+        return "<native fn>";
+    }
+}
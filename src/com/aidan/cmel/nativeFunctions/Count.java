@@ -0,0 +1,30 @@
+package com.aidan.cmel.nativeFunctions;
+
+import com.aidan.cmel.CmelCallable;
+import com.aidan.cmel.CmelIndexable;
+import com.aidan.cmel.Interpreter;
+import com.aidan.cmel.RuntimeError;
+
+import java.util.List;
+
+public class Count implements CmelCallable {
+    @Override
+    public Object call(Interpreter interpreter, List<Object> arguments) {
+        Object collection = arguments.get(0);
+
+        if (collection instanceof CmelIndexable indexable) return (double) indexable.length();
+        if (collection instanceof String string) return (double) string.length();
+
+        throw new RuntimeError("Can only count arrays, collections and strings.");
+    }
+
+    @Override
+    public int arity() {
+        return 1;
+    }
+
+    @Override
+    public String toString() {
+        return "<native fn>";
+    }
+}
@@ -0,0 +1,30 @@
+package com.aidan.cmel.nativeFunctions;
+
+import com.aidan.cmel.CmelCallable;
+import com.aidan.cmel.Effect;
+import com.aidan.cmel.Interpreter;
+
+import java.util.List;
+
+public class Delete implements CmelCallable {
+    @Override
+    public Object call(Interpreter interpreter, List<Object> arguments) {
+        Arguments.store(arguments.get(0)).delete(Arguments.key(arguments.get(1)));
+        return null;
+    }
+
+    @Override
+    public int arity() {
+        return 2;
+    }
+
+    @Override
+    public Effect effect() {
+        return Effect.IO;
+    }
+
+    @Override
+    public String toString() {
+        return "<native fn>";
+    }
+}
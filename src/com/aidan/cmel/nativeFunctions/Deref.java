@@ -0,0 +1,38 @@
+package com.aidan.cmel.nativeFunctions;
+
+import com.aidan.cmel.CmelCallable;
+import com.aidan.cmel.Effect;
+import com.aidan.cmel.Interpreter;
+import com.aidan.cmel.RuntimeError;
+import com.aidan.cmel.collections.WeakRef;
+
+import java.util.List;
+
+// deref(ref) answers the object a weak reference refers to, or nil once it has
+// been collected.
+public class Deref implements CmelCallable {
+    @Override
+    public Object call(Interpreter interpreter, List<Object> arguments) {
+        if (!(arguments.get(0) instanceof WeakRef reference))
+            throw new RuntimeError("Expected a weak reference.");
+
+        return reference.deref();
+    }
+
+    @Override
+    public int arity() {
+        return 1;
+    }
+
+    // Whether the object is still there depends on the collector, so, like
+    // clock, this can't be run at compile time.
+    @Override
+    public Effect effect() {
+        return Effect.IO;
+    }
+
+    @Override
+    public String toString() {
+        return "<native fn>";
+    }
+}
@@ -0,0 +1,38 @@
+package com.aidan.cmel.nativeFunctions;
+
+import com.aidan.cmel.CmelCallable;
+import com.aidan.cmel.Effect;
+import com.aidan.cmel.Interpreter;
+import com.aidan.cmel.RuntimeError;
+import com.aidan.cmel.collections.PersistentHashMap;
+import com.aidan.cmel.collections.TransientHashMap;
+
+import java.util.List;
+
+public class Dissoc implements CmelCallable {
+    @Override
+    public Object call(Interpreter interpreter, List<Object> arguments) {
+        Object collection = arguments.get(0);
+
+        if (collection instanceof PersistentHashMap map) return map.without(arguments.get(1));
+        if (collection instanceof TransientHashMap map) return map.without(arguments.get(1));
+
+        throw new RuntimeError("Can only dissoc from maps.");
+    }
+
+    // The key is removed from a transient map in place.
+    @Override
+    public Effect effect(List<Object> arguments) {
+        return Arguments.isTransient(arguments.get(0)) ? Effect.WRITES : Effect.PURE;
+    }
+
+    @Override
+    public int arity() {
+        return 2;
+    }
+
+    @Override
+    public String toString() {
+        return "<native fn>";
+    }
+}
@@ -0,0 +1,45 @@
+package com.aidan.cmel.nativeFunctions;
+
+import com.aidan.cmel.CmelCallable;
+import com.aidan.cmel.CmelIndexable;
+import com.aidan.cmel.CmelTypedArray;
+import com.aidan.cmel.Effect;
+import com.aidan.cmel.Interpreter;
+import com.aidan.cmel.RuntimeError;
+
+import java.util.List;
+
+// fill(array, value) sets every element of an array to value, and answers
+// the array.
+public class Fill implements CmelCallable {
+    @Override
+    public Object call(Interpreter interpreter, List<Object> arguments) {
+        CmelIndexable array = Arguments.array(arguments.get(0));
+        Object value = arguments.get(1);
+
+        if (array instanceof CmelTypedArray typed) {
+            if (!(value instanceof Double number))
+                throw new RuntimeError("Can only fill a typed array with a number.");
+            typed.fill(number);
+        } else {
+            for (int i = 0; i < array.length(); i++)
+                array.set((double) i, value);
+        }
+        return array;
+    }
+
+    @Override
+    public int arity() {
+        return 2;
+    }
+
+    @Override
+    public Effect effect() {
+        return Effect.WRITES;
+    }
+
+    @Override
+    public String toString() {
+        return "<native fn>";
+    }
+}
@@ -0,0 +1,35 @@
+package com.aidan.cmel.nativeFunctions;
+
+import com.aidan.cmel.CmelCallable;
+import com.aidan.cmel.CmelOffHeapArray;
+import com.aidan.cmel.Effect;
+import com.aidan.cmel.Interpreter;
+import com.aidan.cmel.RuntimeError;
+
+import java.util.List;
+
+public class Free implements CmelCallable {
+    @Override
+    public Object call(Interpreter interpreter, List<Object> arguments) {
+        if (!(arguments.get(0) instanceof CmelOffHeapArray array))
+            throw new RuntimeError("Can only free off-heap arrays.");
+
+        array.free();
+        return null;
+    }
+
+    @Override
+    public int arity() {
+        return 1;
+    }
+
+    @Override
+    public Effect effect() {
+        return Effect.WRITES;
+    }
+
+    @Override
+    public String toString() {
+        return "<native fn>";
+    }
+}
@@ -0,0 +1,23 @@
+package com.aidan.cmel.nativeFunctions;
+
+import com.aidan.cmel.CmelCallable;
+import com.aidan.cmel.Interpreter;
+
+import java.util.List;
+
+public class Gaussian implements CmelCallable {
+    @Override
+    public Object call(Interpreter interpreter, List<Object> arguments) {
+        return interpreter.getRandom().nextGaussian();
+    }
+
+    @Override
+    public int arity() {
+        return 0;
+    }
+
+    @Override
+    public String toString() {
+        return "<native fn>";
+    }
+}
@@ -0,0 +1,47 @@
+package com.aidan.cmel.nativeFunctions;
+
+import com.aidan.cmel.CmelCallable;
+import com.aidan.cmel.Interpreter;
+import com.aidan.cmel.RuntimeError;
+import com.aidan.cmel.collections.ConcurrentMap;
+import com.aidan.cmel.collections.PersistentHashMap;
+import com.aidan.cmel.collections.PersistentVector;
+import com.aidan.cmel.collections.TransientHashMap;
+import com.aidan.cmel.collections.TransientVector;
+import com.aidan.cmel.collections.WeakMap;
+
+import java.util.List;
+
+public class Get implements CmelCallable {
+    @Override
+    public Object call(Interpreter interpreter, List<Object> arguments) {
+        Object collection = arguments.get(0);
+        Object key = arguments.get(1);
+
+        if (collection instanceof PersistentHashMap map) return map.get(key);
+        if (collection instanceof TransientHashMap map) return map.get(key);
+        if (collection instanceof ConcurrentMap map) return map.get(key);
+        if (collection instanceof WeakMap map) return map.get(key);
+
+        if (collection instanceof PersistentVector vector) {
+            int index = Arguments.index(key);
+            return index >= 0 && index < vector.count() ? vector.nth(index) : null;
+        }
+        if (collection instanceof TransientVector vector) {
+            int index = Arguments.index(key);
+            return index >= 0 && index < vector.count() ? vector.nth(index) : null;
+        }
+
+        throw new RuntimeError("Can only get from vectors and maps.");
+    }
+
+    @Override
+    public int arity() {
+        return 2;
+    }
+
+    @Override
+    public String toString() {
+        return "<native fn>";
+    }
+}
@@ -0,0 +1,35 @@
+package com.aidan.cmel.nativeFunctions;
+
+import com.aidan.cmel.CmelCallable;
+import com.aidan.cmel.Effect;
+import com.aidan.cmel.Interpreter;
+import com.aidan.cmel.RuntimeError;
+
+import java.util.List;
+
+// increment(map, key, delta) atomically adds delta to the counter under key,
+// which starts at zero, and answers its new value.
+public class Increment implements CmelCallable {
+    @Override
+    public Object call(Interpreter interpreter, List<Object> arguments) {
+        if (!(arguments.get(2) instanceof Double delta))
+            throw new RuntimeError("Increment must be a number.");
+
+        return Arguments.concurrentMap(arguments.get(0)).increment(arguments.get(1), delta);
+    }
+
+    @Override
+    public int arity() {
+        return 3;
+    }
+
+    @Override
+    public Effect effect() {
+        return Effect.CONCURRENT_WRITES;
+    }
+
+    @Override
+    public String toString() {
+        return "<native fn>";
+    }
+}
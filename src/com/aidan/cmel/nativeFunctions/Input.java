@@ -1,6 +1,7 @@
 package com.aidan.cmel.nativeFunctions;
 
 import com.aidan.cmel.CmelCallable;
+import com.aidan.cmel.Effect;
 import com.aidan.cmel.Interpreter;
 
 import java.io.BufferedReader;
@@ -29,6 +30,11 @@ public class Input implements CmelCallable {
         return 0;
     }
 
+    @Override
+    public Effect effect() {
+        return Effect.IO;
+    }
+
     @Override
     public String toString() {
         return "<native fn>";
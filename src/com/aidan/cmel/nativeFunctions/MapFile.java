@@ -0,0 +1,52 @@
+package com.aidan.cmel.nativeFunctions;
+
+import com.aidan.cmel.CmelCallable;
+import com.aidan.cmel.CmelOffHeapArray;
+import com.aidan.cmel.Effect;
+import com.aidan.cmel.Interpreter;
+import com.aidan.cmel.RuntimeError;
+
+import java.io.IOException;
+import java.lang.foreign.Arena;
+import java.lang.foreign.MemorySegment;
+import java.nio.channels.FileChannel;
+import java.nio.file.Path;
+import java.nio.file.StandardOpenOption;
+import java.util.List;
+
+// Maps a file of native-endian doubles as an off-heap array. Writes to the
+// array go straight to the file.
+public class MapFile implements CmelCallable {
+    @Override
+    public Object call(Interpreter interpreter, List<Object> arguments) {
+        if (!(arguments.get(0) instanceof String path))
+            throw new RuntimeError("File path must be a string.");
+
+        try (FileChannel channel = FileChannel.open(Path.of(path), StandardOpenOption.READ, StandardOpenOption.WRITE)) {
+            long size = channel.size();
+            if (size % Double.BYTES != 0)
+                throw new RuntimeError("File '" + path + "' does not hold a whole number of doubles.");
+
+            Arena arena = Arena.ofShared();
+            MemorySegment segment = channel.map(FileChannel.MapMode.READ_WRITE, 0, size, arena);
+            return new CmelOffHeapArray(segment, arena);
+        } catch (IOException e) {
+            throw new RuntimeError("Could not map file '" + path + "': " + e.getMessage());
+        }
+    }
+
+    @Override
+    public int arity() {
+        return 1;
+    }
+
+    @Override
+    public Effect effect() {
+        return Effect.IO;
+    }
+
+    @Override
+    public String toString() {
+        return "<native fn>";
+    }
+}
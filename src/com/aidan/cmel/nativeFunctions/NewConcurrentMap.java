@@ -0,0 +1,24 @@
+package com.aidan.cmel.nativeFunctions;
+
+import com.aidan.cmel.CmelCallable;
+import com.aidan.cmel.Interpreter;
+import com.aidan.cmel.collections.ConcurrentMap;
+
+import java.util.List;
+
+public class NewConcurrentMap implements CmelCallable {
+    @Override
+    public Object call(Interpreter interpreter, List<Object> arguments) {
+        return interpreter.allocated(new ConcurrentMap());
+    }
+
+    @Override
+    public int arity() {
+        return 0;
+    }
+
+    @Override
+    public String toString() {
+        return "<native fn>";
+    }
+}
@@ -0,0 +1,29 @@
+package com.aidan.cmel.nativeFunctions;
+
+import com.aidan.cmel.CmelCallable;
+import com.aidan.cmel.CmelFloat32Array;
+import com.aidan.cmel.Interpreter;
+import com.aidan.cmel.RuntimeError;
+
+import java.util.List;
+
+public class NewFloat32Array implements CmelCallable {
+    @Override
+    public Object call(Interpreter interpreter, List<Object> arguments) {
+        int length = Arguments.index(arguments.get(0));
+        if (length < 0)
+            throw new RuntimeError("Array length can't be negative.");
+
+        return interpreter.allocated(new CmelFloat32Array(length));
+    }
+
+    @Override
+    public int arity() {
+        return 1;
+    }
+
+    @Override
+    public String toString() {
+        return "<native fn>";
+    }
+}
@@ -0,0 +1,24 @@
+package com.aidan.cmel.nativeFunctions;
+
+import com.aidan.cmel.CmelCallable;
+import com.aidan.cmel.Interpreter;
+import com.aidan.cmel.collections.PersistentHashMap;
+
+import java.util.List;
+
+public class NewHashMap implements CmelCallable {
+    @Override
+    public Object call(Interpreter interpreter, List<Object> arguments) {
+        return PersistentHashMap.EMPTY;
+    }
+
+    @Override
+    public int arity() {
+        return 0;
+    }
+
+    @Override
+    public String toString() {
+        return "<native fn>";
+    }
+}
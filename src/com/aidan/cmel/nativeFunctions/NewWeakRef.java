@@ -0,0 +1,29 @@
+package com.aidan.cmel.nativeFunctions;
+
+import com.aidan.cmel.CmelCallable;
+import com.aidan.cmel.Interpreter;
+import com.aidan.cmel.RuntimeError;
+import com.aidan.cmel.collections.WeakRef;
+
+import java.util.List;
+
+public class NewWeakRef implements CmelCallable {
+    @Override
+    public Object call(Interpreter interpreter, List<Object> arguments) {
+        Object referent = arguments.get(0);
+        if (referent == null || referent instanceof Double || referent instanceof String || referent instanceof Boolean)
+            throw new RuntimeError("Can only make weak references to objects.");
+
+        return interpreter.allocated(new WeakRef(referent));
+    }
+
+    @Override
+    public int arity() {
+        return 1;
+    }
+
+    @Override
+    public String toString() {
+        return "<native fn>";
+    }
+}
@@ -0,0 +1,38 @@
+package com.aidan.cmel.nativeFunctions;
+
+import com.aidan.cmel.CmelCallable;
+import com.aidan.cmel.Effect;
+import com.aidan.cmel.Interpreter;
+import com.aidan.cmel.RuntimeError;
+import com.aidan.cmel.collections.TransientHashMap;
+import com.aidan.cmel.collections.TransientVector;
+
+import java.util.List;
+
+public class Persistent implements CmelCallable {
+    @Override
+    public Object call(Interpreter interpreter, List<Object> arguments) {
+        Object collection = arguments.get(0);
+
+        if (collection instanceof TransientVector vector) return vector.persistent();
+        if (collection instanceof TransientHashMap map) return map.persistent();
+
+        throw new RuntimeError("Can only make a transient persistent.");
+    }
+
+    @Override
+    public int arity() {
+        return 1;
+    }
+
+    // Ends the transient it is given.
+    @Override
+    public Effect effect() {
+        return Effect.WRITES;
+    }
+
+    @Override
+    public String toString() {
+        return "<native fn>";
+    }
+}
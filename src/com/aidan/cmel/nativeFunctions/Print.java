@@ -1,6 +1,7 @@
 package com.aidan.cmel.nativeFunctions;
 
 import com.aidan.cmel.CmelCallable;
+import com.aidan.cmel.Effect;
 import com.aidan.cmel.Interpreter;
 
 import java.util.List;
@@ -30,6 +31,11 @@ public class Print implements CmelCallable {
         return 1;
     }
 
+    @Override
+    public Effect effect() {
+        return Effect.IO;
+    }
+
     @Override
     public String toString() {
         return "<native fn>";
@@ -0,0 +1,32 @@
+package com.aidan.cmel.nativeFunctions;
+
+import com.aidan.cmel.CmelCallable;
+import com.aidan.cmel.Effect;
+import com.aidan.cmel.Interpreter;
+import com.aidan.cmel.store.KeyValueStore;
+
+import java.util.List;
+
+public class Put implements CmelCallable {
+    @Override
+    public Object call(Interpreter interpreter, List<Object> arguments) {
+        KeyValueStore store = Arguments.store(arguments.get(0));
+        store.put(Arguments.key(arguments.get(1)), arguments.get(2));
+        return arguments.get(2);
+    }
+
+    @Override
+    public int arity() {
+        return 3;
+    }
+
+    @Override
+    public Effect effect() {
+        return Effect.IO;
+    }
+
+    @Override
+    public String toString() {
+        return "<native fn>";
+    }
+}
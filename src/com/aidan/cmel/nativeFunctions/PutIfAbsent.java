@@ -0,0 +1,31 @@
+package com.aidan.cmel.nativeFunctions;
+
+import com.aidan.cmel.CmelCallable;
+import com.aidan.cmel.Effect;
+import com.aidan.cmel.Interpreter;
+
+import java.util.List;
+
+// putIfAbsent(map, key, value) answers the value already stored under key, or
+// nil once it has stored the new one.
+public class PutIfAbsent implements CmelCallable {
+    @Override
+    public Object call(Interpreter interpreter, List<Object> arguments) {
+        return Arguments.concurrentMap(arguments.get(0)).putIfAbsent(arguments.get(1), arguments.get(2));
+    }
+
+    @Override
+    public int arity() {
+        return 3;
+    }
+
+    @Override
+    public Effect effect() {
+        return Effect.CONCURRENT_WRITES;
+    }
+
+    @Override
+    public String toString() {
+        return "<native fn>";
+    }
+}
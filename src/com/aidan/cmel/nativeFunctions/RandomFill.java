@@ -0,0 +1,39 @@
+package com.aidan.cmel.nativeFunctions;
+
+import com.aidan.cmel.CmelCallable;
+import com.aidan.cmel.CmelFloat64Array;
+import com.aidan.cmel.CmelOffHeapArray;
+import com.aidan.cmel.Effect;
+import com.aidan.cmel.Interpreter;
+import com.aidan.cmel.RuntimeError;
+
+import java.util.List;
+import java.util.SplittableRandom;
+
+public class RandomFill implements CmelCallable {
+    @Override
+    public Object call(Interpreter interpreter, List<Object> arguments) {
+        SplittableRandom random = interpreter.getRandom();
+        Object array = arguments.get(0);
+
+        if (array instanceof CmelFloat64Array numbers) numbers.fill(random::nextDouble);
+        else if (array instanceof CmelOffHeapArray numbers) numbers.fill(random::nextDouble);
+        else throw new RuntimeError("Can only fill float64 and off-heap arrays.");
+        return array;
+    }
+
+    @Override
+    public int arity() {
+        return 1;
+    }
+
+    @Override
+    public Effect effect() {
+        return Effect.WRITES;
+    }
+
+    @Override
+    public String toString() {
+        return "<native fn>";
+    }
+}
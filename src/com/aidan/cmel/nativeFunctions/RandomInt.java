@@ -0,0 +1,29 @@
+package com.aidan.cmel.nativeFunctions;
+
+import com.aidan.cmel.CmelCallable;
+import com.aidan.cmel.Interpreter;
+import com.aidan.cmel.RuntimeError;
+
+import java.util.List;
+
+public class RandomInt implements CmelCallable {
+    @Override
+    public Object call(Interpreter interpreter, List<Object> arguments) {
+        int low = Arguments.index(arguments.get(0));
+        int high = Arguments.index(arguments.get(1));
+        if (low >= high)
+            throw new RuntimeError("randomInt needs a lower bound below its upper bound.");
+
+        return (double) interpreter.getRandom().nextInt(low, high);
+    }
+
+    @Override
+    public int arity() {
+        return 2;
+    }
+
+    @Override
+    public String toString() {
+        return "<native fn>";
+    }
+}
@@ -0,0 +1,60 @@
+package com.aidan.cmel.nativeFunctions;
+
+import com.aidan.cmel.CmelCallable;
+import com.aidan.cmel.CmelIndexable;
+import com.aidan.cmel.Effect;
+import com.aidan.cmel.Interpreter;
+import com.aidan.cmel.RuntimeError;
+import com.aidan.cmel.collections.PersistentVector;
+import com.aidan.cmel.collections.TransientVector;
+
+import java.util.List;
+import java.util.SplittableRandom;
+
+// Shuffles arrays and transient vectors in place. A persistent vector can't
+// change, so a shuffled copy is returned instead.
+public class Shuffle implements CmelCallable {
+    @Override
+    public Object call(Interpreter interpreter, List<Object> arguments) {
+        Object collection = arguments.get(0);
+
+        if (collection instanceof PersistentVector vector) {
+            TransientVector copy = vector.asTransient();
+            shuffle(copy, interpreter.getRandom());
+            return copy.persistent();
+        }
+        if (collection instanceof TransientVector
+                || collection instanceof CmelIndexable indexable && indexable.hasIndependentSlots()) {
+            shuffle((CmelIndexable) collection, interpreter.getRandom());
+            return collection;
+        }
+
+        throw new RuntimeError("Can only shuffle arrays and vectors.");
+    }
+
+    // Fisher-Yates.
+    private static void shuffle(CmelIndexable elements, SplittableRandom random) {
+        for (int i = elements.length() - 1; i > 0; i--) {
+            Object index = (double) i;
+            Object other = (double) random.nextInt(i + 1);
+            Object element = elements.get(index);
+            elements.set(index, elements.get(other));
+            elements.set(other, element);
+        }
+    }
+
+    @Override
+    public int arity() {
+        return 1;
+    }
+
+    @Override
+    public Effect effect() {
+        return Effect.WRITES;
+    }
+
+    @Override
+    public String toString() {
+        return "<native fn>";
+    }
+}
@@ -0,0 +1,31 @@
+package com.aidan.cmel.nativeFunctions;
+
+import com.aidan.cmel.CmelCallable;
+import com.aidan.cmel.Interpreter;
+import com.aidan.cmel.RuntimeError;
+import com.aidan.cmel.collections.PersistentHashMap;
+import com.aidan.cmel.collections.PersistentVector;
+
+import java.util.List;
+
+public class Transient implements CmelCallable {
+    @Override
+    public Object call(Interpreter interpreter, List<Object> arguments) {
+        Object collection = arguments.get(0);
+
+        if (collection instanceof PersistentVector vector) return interpreter.allocated(vector.asTransient());
+        if (collection instanceof PersistentHashMap map) return interpreter.allocated(map.asTransient());
+
+        throw new RuntimeError("Can only make a transient from a vector or map.");
+    }
+
+    @Override
+    public int arity() {
+        return 1;
+    }
+
+    @Override
+    public String toString() {
+        return "<native fn>";
+    }
+}
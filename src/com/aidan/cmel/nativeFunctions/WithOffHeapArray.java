@@ -0,0 +1,45 @@
+package com.aidan.cmel.nativeFunctions;
+
+import com.aidan.cmel.CmelCallable;
+import com.aidan.cmel.CmelOffHeapArray;
+import com.aidan.cmel.Effect;
+import com.aidan.cmel.Interpreter;
+import com.aidan.cmel.RuntimeError;
+
+import java.util.List;
+
+// withOffHeapArray(n, fun (a) { ... }) allocates an off-heap array for the
+// duration of the call and frees it afterwards, however the call ends.
+public class WithOffHeapArray implements CmelCallable {
+    @Override
+    public Object call(Interpreter interpreter, List<Object> arguments) {
+        int length = Arguments.index(arguments.get(0));
+        if (length < 0)
+            throw new RuntimeError("Array length can't be negative.");
+        if (!(arguments.get(1) instanceof CmelCallable function) || function.arity() != 1)
+            throw new RuntimeError("Expected a function of one argument.");
+
+        CmelOffHeapArray array = CmelOffHeapArray.allocate(length);
+        try {
+            return function.call(interpreter, List.of(array));
+        } finally {
+            array.free();
+        }
+    }
+
+    @Override
+    public int arity() {
+        return 2;
+    }
+
+    // It runs whatever function it is given.
+    @Override
+    public Effect effect() {
+        return Effect.IO;
+    }
+
+    @Override
+    public String toString() {
+        return "<native fn>";
+    }
+}
@@ -0,0 +1,49 @@
+package com.aidan.cmel.nativeFunctions;
+
+import com.aidan.cmel.CmelArray;
+import com.aidan.cmel.CmelCallable;
+import com.aidan.cmel.Effect;
+import com.aidan.cmel.Interpreter;
+import com.aidan.cmel.RuntimeError;
+import com.aidan.cmel.WorkerPool;
+import com.aidan.cmel.collections.PersistentVector;
+
+import java.util.ArrayList;
+import java.util.List;
+
+// workerMap(pool, fn, inputs) runs fn on each element of a vector or array in
+// the pool's workers and answers a vector of the results.
+public class WorkerMap implements CmelCallable {
+    @Override
+    public Object call(Interpreter interpreter, List<Object> arguments) {
+        if (!(arguments.get(0) instanceof WorkerPool pool))
+            throw new RuntimeError("Expected a worker pool.");
+
+        List<Object> inputs = new ArrayList<>();
+        Object collection = arguments.get(2);
+        if (collection instanceof PersistentVector vector) {
+            for (int i = 0; i < vector.count(); i++) inputs.add(vector.nth(i));
+        } else if (collection instanceof CmelArray array) {
+            for (int i = 0; i < array.length(); i++) inputs.add(array.get((double) i));
+        } else {
+            throw new RuntimeError("Worker inputs must be a vector or an array.");
+        }
+
+        return pool.map(interpreter, arguments.get(1), inputs);
+    }
+
+    @Override
+    public int arity() {
+        return 3;
+    }
+
+    @Override
+    public Effect effect() {
+        return Effect.IO;
+    }
+
+    @Override
+    public String toString() {
+        return "<native fn>";
+    }
+}
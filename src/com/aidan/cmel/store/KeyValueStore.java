@@ -0,0 +1,348 @@
+package com.aidan.cmel.store;
+
+import com.aidan.cmel.CmelIndexable;
+import com.aidan.cmel.RuntimeError;
+import com.aidan.cmel.ValueCodec;
+import com.aidan.cmel.collections.PersistentHashMap;
+import com.aidan.cmel.collections.TransientHashMap;
+
+import java.io.ByteArrayInputStream;
+import java.io.ByteArrayOutputStream;
+import java.io.DataInputStream;
+import java.io.DataOutputStream;
+import java.io.IOException;
+import java.lang.foreign.Arena;
+import java.lang.foreign.MemorySegment;
+import java.lang.foreign.ValueLayout;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.nio.channels.FileChannel;
+import java.nio.charset.StandardCharsets;
+import java.nio.file.Files;
+import java.nio.file.Path;
+import java.nio.file.StandardCopyOption;
+import java.nio.file.StandardOpenOption;
+import java.util.Arrays;
+import java.util.Map;
+import java.util.TreeMap;
+import java.util.zip.CRC32;
+
+// A string-keyed store kept in an append-only log: the bytes of MAGIC, then
+// records
+//
+//     int bodyLength, int crc32(type, keyLength, key), int crc32(value),
+//     body = byte type, int keyLength, key, value
+//
+// with values in ValueCodec's format. Opening maps the log and reads only the
+// record headers and keys into an index, checking them against their own
+// checksum; a value is checked and decoded from the mapping the first time it
+// is asked for. A torn record at the end of the log, left by a crash
+// mid-append, is cut off on open: only the last record can be torn, so its
+// value is checked then too. Compaction writes the live records to a new file
+// and atomically renames it over the log.
+public final class KeyValueStore implements CmelIndexable {
+    private static final byte PUT = 1;
+    private static final byte DELETE = 2;
+    private static final int HEADER = 3 * Integer.BYTES;
+    // Identifies the log format, so that a file in any other isn't mistaken
+    // for a torn log and cut off.
+    private static final byte[] MAGIC = "cmelkv2\n".getBytes(StandardCharsets.US_ASCII);
+    private static final ValueLayout.OfInt INT = ValueLayout.JAVA_INT_UNALIGNED.withOrder(ByteOrder.BIG_ENDIAN);
+
+    // Where a live key's value sits in the log, and its checksum.
+    private static final class Location {
+        final long offset;
+        final int length;
+        final int crc;
+        boolean verified;
+
+        Location(long offset, int length, int crc, boolean verified) {
+            this.offset = offset;
+            this.length = length;
+            this.crc = crc;
+            this.verified = verified;
+        }
+    }
+
+    private final Path path;
+    private final TreeMap<String, Location> index = new TreeMap<>();
+    private FileChannel channel;
+    private Arena arena;
+    private MemorySegment mapping;
+    private long size;
+    private boolean closed = false;
+
+    private KeyValueStore(Path path) {
+        this.path = path;
+    }
+
+    public static KeyValueStore open(String path) {
+        KeyValueStore store = new KeyValueStore(Path.of(path));
+        try {
+            Files.deleteIfExists(store.compactionPath());
+            store.load();
+        } catch (IOException e) {
+            throw new RuntimeError("Could not open store '" + path + "': " + e.getMessage());
+        }
+        return store;
+    }
+
+    private Path compactionPath() {
+        return path.resolveSibling(path.getFileName() + ".compact");
+    }
+
+    private void load() throws IOException {
+        channel = FileChannel.open(path, StandardOpenOption.CREATE, StandardOpenOption.READ, StandardOpenOption.WRITE);
+        size = channel.size();
+        if (size == 0) {
+            write(channel, ByteBuffer.wrap(MAGIC));
+            channel.force(true);
+            size = MAGIC.length;
+        }
+        remap();
+        index.clear();
+
+        if (size < MAGIC.length || !Arrays.equals(mapping.asSlice(0, MAGIC.length).toArray(ValueLayout.JAVA_BYTE), MAGIC)) {
+            arena.close();
+            channel.close();
+            throw new IOException("not a store, or one written in an older format");
+        }
+
+        long offset = MAGIC.length;
+        while (offset + HEADER <= size) {
+            int bodyLength = mapping.get(INT, offset);
+            if (bodyLength < 1 + Integer.BYTES || offset + HEADER + bodyLength > size) break;
+
+            long body = offset + HEADER;
+            int keyLength = mapping.get(INT, body + 1);
+            if (keyLength < 0 || keyLength > bodyLength - 1 - Integer.BYTES) break;
+            int valueStart = 1 + Integer.BYTES + keyLength;
+            if (crc(mapping.asSlice(body, valueStart)) != mapping.get(INT, offset + Integer.BYTES)) break;
+
+            byte type = mapping.get(ValueLayout.JAVA_BYTE, body);
+            String key = new String(mapping.asSlice(body + 1 + Integer.BYTES, keyLength).toArray(ValueLayout.JAVA_BYTE),
+                    StandardCharsets.UTF_8);
+            Location value = new Location(body + valueStart, bodyLength - valueStart,
+                    mapping.get(INT, offset + 2 * Integer.BYTES), false);
+            if (body + bodyLength == size && !isIntact(value)) break;
+
+            if (type == PUT) index.put(key, value);
+            else index.remove(key);
+            offset = body + bodyLength;
+        }
+
+        if (offset < size) {
+            channel.truncate(offset);
+            channel.force(true);
+            size = offset;
+            remap();
+        }
+    }
+
+    // Appends go through the channel; the mapping only catches up when a read
+    // reaches past its end.
+    private void ensureMapped() {
+        if (mapping.byteSize() >= size) return;
+        try {
+            remap();
+        } catch (IOException e) {
+            throw new RuntimeError("Could not map store: " + e.getMessage());
+        }
+    }
+
+    private void remap() throws IOException {
+        if (arena != null) arena.close();
+        arena = Arena.ofShared();
+        mapping = size == 0
+                ? MemorySegment.ofArray(new byte[0])
+                : channel.map(FileChannel.MapMode.READ_ONLY, 0, size, arena);
+    }
+
+    @Override
+    public synchronized Object get(Object key) {
+        Location location = index.get(checkKey(key));
+        if (location == null) return null;
+        return read(location);
+    }
+
+    @Override
+    public synchronized void set(Object key, Object value) {
+        put(checkKey(key), value);
+    }
+
+    @Override
+    public synchronized int length() {
+        return index.size();
+    }
+
+    public synchronized void put(String key, Object value) {
+        ByteArrayOutputStream bytes = new ByteArrayOutputStream();
+        try (DataOutputStream out = new DataOutputStream(bytes)) {
+            ValueCodec.write(out, value);
+        } catch (IOException e) {
+            throw new RuntimeError("Could not encode value: " + e.getMessage());
+        }
+        append(PUT, key, bytes.toByteArray());
+    }
+
+    public synchronized void delete(String key) {
+        if (index.containsKey(key)) append(DELETE, key, new byte[0]);
+    }
+
+    // Every entry whose key starts with prefix.
+    public synchronized PersistentHashMap scan(String prefix) {
+        TransientHashMap result = PersistentHashMap.EMPTY.asTransient();
+        for (Map.Entry<String, Location> entry : index.tailMap(prefix, true).entrySet()) {
+            if (!entry.getKey().startsWith(prefix)) break;
+            result.assoc(entry.getKey(), read(entry.getValue()));
+        }
+        return result.persistent();
+    }
+
+    public synchronized void compact() {
+        ensureOpen();
+        ensureMapped();
+        Path temporary = compactionPath();
+        try {
+            Files.deleteIfExists(temporary);
+        } catch (IOException e) {
+            throw new RuntimeError("Could not compact store: " + e.getMessage());
+        }
+        try (FileChannel out = FileChannel.open(temporary, StandardOpenOption.CREATE_NEW, StandardOpenOption.WRITE)) {
+            write(out, ByteBuffer.wrap(MAGIC));
+            for (Map.Entry<String, Location> entry : index.entrySet())
+                write(out, record(PUT, entry.getKey(), valueBytes(entry.getValue())));
+            out.force(true);
+        } catch (IOException e) {
+            throw new RuntimeError("Could not compact store: " + e.getMessage());
+        }
+
+        try {
+            arena.close();
+            arena = null;
+            channel.close();
+            Files.move(temporary, path, StandardCopyOption.ATOMIC_MOVE, StandardCopyOption.REPLACE_EXISTING);
+            syncDirectory();
+            load();
+        } catch (IOException e) {
+            closed = true;
+            throw new RuntimeError("Could not replace store with its compacted log: " + e.getMessage());
+        }
+    }
+
+    public synchronized void close() {
+        if (closed) return;
+        closed = true;
+        try {
+            arena.close();
+            channel.close();
+        } catch (IOException e) {
+            throw new RuntimeError("Could not close store: " + e.getMessage());
+        }
+    }
+
+    private void append(byte type, String key, byte[] value) {
+        ensureOpen();
+        ByteBuffer record = record(type, key, value);
+        long start = size;
+        try {
+            channel.position(start);
+            write(channel, record);
+            channel.force(false);
+            size = channel.size();
+        } catch (IOException e) {
+            throw new RuntimeError("Could not write to store: " + e.getMessage());
+        }
+
+        int valueLength = value.length;
+        if (type == PUT) index.put(key, new Location(size - valueLength, valueLength, crc(value), true));
+        else index.remove(key);
+    }
+
+    private static ByteBuffer record(byte type, String key, byte[] value) {
+        byte[] keyBytes = key.getBytes(StandardCharsets.UTF_8);
+        int keyEnd = 1 + Integer.BYTES + keyBytes.length;
+        ByteBuffer body = ByteBuffer.allocate(keyEnd + value.length);
+        body.put(type).putInt(keyBytes.length).put(keyBytes).put(value);
+
+        CRC32 keyCrc = new CRC32();
+        keyCrc.update(body.array(), 0, keyEnd);
+
+        ByteBuffer record = ByteBuffer.allocate(HEADER + body.capacity());
+        record.putInt(body.capacity()).putInt((int) keyCrc.getValue()).putInt(crc(value)).put(body.array());
+        return record.flip();
+    }
+
+    private static int crc(byte[] bytes) {
+        CRC32 crc = new CRC32();
+        crc.update(bytes);
+        return (int) crc.getValue();
+    }
+
+    private static int crc(MemorySegment bytes) {
+        CRC32 crc = new CRC32();
+        crc.update(bytes.asByteBuffer());
+        return (int) crc.getValue();
+    }
+
+    private boolean isIntact(Location location) {
+        if (!location.verified)
+            location.verified = crc(mapping.asSlice(location.offset, location.length)) == location.crc;
+        return location.verified;
+    }
+
+    // A rename is only durable once the directory holding it is synced. Not
+    // every platform can open a directory; there the rename is as durable as
+    // it gets.
+    private void syncDirectory() throws IOException {
+        Path directory = path.toAbsolutePath().getParent();
+        FileChannel handle;
+        try {
+            handle = FileChannel.open(directory, StandardOpenOption.READ);
+        } catch (IOException e) {
+            return;
+        }
+        try (handle) {
+            handle.force(true);
+        }
+    }
+
+    private static void write(FileChannel channel, ByteBuffer buffer) throws IOException {
+        while (buffer.hasRemaining()) channel.write(buffer);
+    }
+
+    private Object read(Location location) {
+        ensureOpen();
+        ensureMapped();
+        try {
+            return ValueCodec.read(new DataInputStream(new ByteArrayInputStream(valueBytes(location))));
+        } catch (IOException e) {
+            throw new RuntimeError("Store holds a corrupt value: " + e.getMessage());
+        }
+    }
+
+    private byte[] valueBytes(Location location) {
+        byte[] bytes = new byte[location.length];
+        MemorySegment.copy(mapping, ValueLayout.JAVA_BYTE, location.offset, bytes, 0, location.length);
+        if (!location.verified) {
+            if (crc(bytes) != location.crc) throw new RuntimeError("Store holds a corrupt value.");
+            location.verified = true;
+        }
+        return bytes;
+    }
+
+    private static String checkKey(Object key) {
+        if (!(key instanceof String string))
+            throw new RuntimeError("Store keys must be strings.");
+        return string;
+    }
+
+    private void ensureOpen() {
+        if (closed) throw new RuntimeError("Store has been closed.");
+    }
+
+    @Override
+    public String toString() {
+        return "<store " + path + ">";
+    }
+}
@@ -0,0 +1,183 @@
+package com.aidan.tools;
+
+import com.aidan.cmel.CmelCallable;
+import com.aidan.cmel.Interpreter;
+import com.aidan.cmel.Parser;
+import com.aidan.cmel.Resolver;
+import com.aidan.cmel.Scanner;
+import com.aidan.cmel.collections.ConcurrentMap;
+
+import java.util.HashMap;
+import java.util.List;
+import java.util.Map;
+import java.util.SplittableRandom;
+import java.util.concurrent.CountDownLatch;
+import java.util.concurrent.atomic.LongAdder;
+
+// Measures the throughput of the concurrentMap native's operations on 1, 2,
+// 4, ... threads, against the same workload on a HashMap behind one lock. Each
+// thread mostly reads a shared cache, sometimes fills a missing entry with
+// computeIfAbsent, and bumps a counter. Then runs a like workload from Cmel,
+// as a parallel for over one map against the same loop run serially, with
+// putIfAbsent in place of computeIfAbsent, whose function may do anything.
+public class ConcurrentMapBenchmark {
+    private static final int KEYS = 10_000;
+    private static final long WARMUP_MILLIS = 1_000;
+    private static final long RUN_MILLIS = 3_000;
+    private static final int ITERATIONS = 2_000_000;
+
+    private static final String PROGRAM = """
+            var cache = concurrentMap();
+            for (var i = 0; i < %d; i = i + 1) putIfAbsent(cache, i, i * i);
+
+            fun step() {
+                var key = randomInt(0, %d);
+                var choice = randomInt(0, 100);
+                if (choice < 90) get(cache, key);
+                else if (choice < 99) putIfAbsent(cache, key, key * key);
+                else increment(cache, "hits", 1);
+            }
+
+            fun inParallel(n) {
+                parallel for (var i = 0; i < n; i = i + 1) step();
+            }
+
+            fun serially(n) {
+                for (var i = 0; i < n; i = i + 1) step();
+            }
+            """.formatted(KEYS / 2, KEYS);
+
+    private interface Target {
+        Object get(Object key);
+        Object computeIfAbsent(Interpreter interpreter, Object key, CmelCallable function);
+        void increment(Object key);
+    }
+
+    private static final class Concurrent implements Target {
+        private final ConcurrentMap map = new ConcurrentMap();
+
+        public Object get(Object key) {
+            return map.get(key);
+        }
+
+        public Object computeIfAbsent(Interpreter interpreter, Object key, CmelCallable function) {
+            return map.computeIfAbsent(interpreter, key, function);
+        }
+
+        public void increment(Object key) {
+            map.increment(key, 1);
+        }
+    }
+
+    private static final class Locked implements Target {
+        private final Map<Object, Object> map = new HashMap<>();
+
+        public synchronized Object get(Object key) {
+            return map.get(key);
+        }
+
+        public synchronized Object computeIfAbsent(Interpreter interpreter, Object key, CmelCallable function) {
+            Object value = map.get(key);
+            if (value == null) {
+                value = function.call(interpreter, List.of(key));
+                map.put(key, value);
+            }
+            return value;
+        }
+
+        public synchronized void increment(Object key) {
+            map.merge(key, 1.0, (a, b) -> (Double) a + (Double) b);
+        }
+    }
+
+    // Stands in for a Cmel function that is costly to call.
+    private static final CmelCallable SQUARE = new CmelCallable() {
+        @Override
+        public Object call(Interpreter interpreter, List<Object> arguments) {
+            double key = (Double) arguments.get(0);
+            return key * key;
+        }
+
+        @Override
+        public int arity() {
+            return 1;
+        }
+    };
+
+    public static void main(String[] args) throws InterruptedException {
+        int maxThreads = args.length > 0 ? Integer.parseInt(args[0]) : Runtime.getRuntime().availableProcessors();
+
+        System.out.printf("%8s %18s %18s %10s%n", "threads", "concurrent ops/s", "locked ops/s", "speedup");
+        double base = 0;
+        for (int threads = 1; threads <= maxThreads; threads *= 2) {
+            double concurrent = measure(new Concurrent(), threads);
+            double locked = measure(new Locked(), threads);
+            if (threads == 1) base = concurrent;
+            System.out.printf("%8d %18.0f %18.0f %9.2fx%n", threads, concurrent, locked, concurrent / base);
+        }
+
+        Interpreter interpreter = new Interpreter("benchmark");
+        run(interpreter, PROGRAM);
+        run(interpreter, "inParallel(" + ITERATIONS + "); serially(" + ITERATIONS + ");");
+        double serial = ITERATIONS / seconds(interpreter, "serially(" + ITERATIONS + ");");
+        double parallel = ITERATIONS / seconds(interpreter, "inParallel(" + ITERATIONS + ");");
+        System.out.printf("%n%-12s %18s %18s %10s%n", "cmel", "parallel ops/s", "serial ops/s", "speedup");
+        System.out.printf("%-12s %18.0f %18.0f %9.2fx%n", "", parallel, serial, parallel / serial);
+    }
+
+    private static void run(Interpreter interpreter, String source) {
+        interpreter.interpret(new Parser(new Scanner(source), new Resolver(interpreter)).parse());
+    }
+
+    private static double seconds(Interpreter interpreter, String source) {
+        long start = System.nanoTime();
+        run(interpreter, source);
+        return (System.nanoTime() - start) / 1e9;
+    }
+
+    private static double measure(Target target, int threads) throws InterruptedException {
+        for (int i = 0; i < KEYS / 2; i++)
+            target.computeIfAbsent(null, (double) i, SQUARE);
+
+        run(target, threads, WARMUP_MILLIS);
+        return run(target, threads, RUN_MILLIS) * 1000.0 / RUN_MILLIS;
+    }
+
+    private static long run(Target target, int threads, long millis) throws InterruptedException {
+        LongAdder operations = new LongAdder();
+        CountDownLatch start = new CountDownLatch(1);
+        Thread[] workers = new Thread[threads];
+        long deadline = System.nanoTime() + millis * 1_000_000 + 50_000_000;
+
+        for (int t = 0; t < threads; t++) {
+            SplittableRandom random = new SplittableRandom(t);
+            workers[t] = new Thread(() -> {
+                Interpreter interpreter = new Interpreter("benchmark");
+                long count = 0;
+                try {
+                    start.await();
+                } catch (InterruptedException e) {
+                    return;
+                }
+                while (System.nanoTime() < deadline) {
+                    for (int i = 0; i < 256; i++) {
+                        double key = random.nextInt(KEYS);
+                        int choice = random.nextInt(100);
+                        if (choice < 90) target.get(key);
+                        else if (choice < 99) target.computeIfAbsent(interpreter, key, SQUARE);
+                        else target.increment("hits");
+                    }
+                    count += 256;
+                }
+                operations.add(count);
+            });
+            workers[t].start();
+        }
+
+        // Give the threads time to reach the latch before the clock starts.
+        Thread.sleep(50);
+        start.countDown();
+        for (Thread worker : workers) worker.join();
+        return operations.sum();
+    }
+}
@@ -14,30 +14,40 @@ public class GenerateAst {
         String outputDir = args[0];
 
         defineAst(outputDir, "Expression", List.of(
-                "Assign : Token name, Expression value",
+                "Assign : Token name, Expression value : int numberSlot",
                 "Ternary : Expression test, Token question, Expression left, Token colon, Expression right",
                 "Binary : Expression left, Token operator, Expression right",
                 "Logical: Expression left, Token operator, Expression right",
                 "Grouping : Expression expression",
                 "Literal : Object value",
                 "Unary : Token operator, Expression right",
-                "Call : Expression callee, Token paren, List<Expression> arguments",
-                "Get : Expression object, Token name",
-                "Set: Expression object, Token name, Expression value",
+                "Call : Expression callee, Token paren, List<Expression> arguments : CallSite site",
+                "Get : Expression object, Token name : Token slot",
+                "Set: Expression object, Token name, Expression value : Token slot",
                 "This: Token keyword",
-                "Variable : Token name",
-                "AnonFunction : List<Token> parameters, List<Statement> body"
+                "Variable : Token name : int numberSlot",
+                "AnonFunction : List<Token> parameters, List<Statement> body : boolean hoistable, CmelAnonFunction hoisted",
+                "Comptime : Token keyword, Expression expression : Object value",
+                "Index : Expression object, Token bracket, Expression index",
+                "IndexSet : Expression object, Token bracket, Expression index, Expression value",
+                "Interpolation : Token quote, List<String> strings, List<Expression> values, int literalLength",
+                "LessThanConstant : Variable variable, Token operator, double constant",
+                "IncrementBy : Variable variable, Token operator, double amount",
+                "GetThisField : This object, Token name",
+                "CallVariable : Variable callee, Token paren, List<Expression> arguments : CallSite site"
         ));
 
         defineAst(outputDir, "Statement", List.of(
                 "Block : List<Statement> statements",
                 "ExpressionStatement : Expression expression",
                 "IfStatement : Expression condition, Statement thenBranch, Statement elseBranch",
-                "Var : Token name, Expression initializer",
-                "While : Expression condition, Statement body",
+                "Var : Token name, Expression initializer : ScalarReplacement scalar, int numberSlot",
+                "While : Expression condition, Statement body : boolean kernelChecked, ArrayKernel kernel",
                 "Function : Token name, List<Token> parameters, List<Statement> body",
                 "Return : Token keyword, Expression value",
-                "Class : Token name, List<Statement.Function> methods"
+                "Class : Token name, List<Statement.Function> methods",
+                "ParallelFor : Token keyword, Token variable, Expression start, Expression end, Statement body : EffectAnalyzer.Summary summary",
+                "Atomic : Token keyword, Statement body"
         ));
     }
 
@@ -56,16 +66,18 @@ public class GenerateAst {
         writer.println("abstract <R> R accept(Visitor<R> visitor);".indent(4));
 
         for (String type : types) {
-            String className = type.split(":")[0].trim();
-            String fields = type.split(":")[1].trim();
-            defineType(writer, baseName, className, fields);
+            String[] parts = type.split(":");
+            String className = parts[0].trim();
+            String fields = parts[1].trim();
+            String mutableFields = parts.length > 2 ? parts[2].trim() : null;
+            defineType(writer, baseName, className, fields, mutableFields);
         }
 
         writer.print("}");
         writer.close();
     }
 
-    private static void defineType(PrintWriter writer, String baseName, String className, String fields) {
+    private static void defineType(PrintWriter writer, String baseName, String className, String fields, String mutableFields) {
         String[] fieldList = fields.split(",");
         writer.print(("static class " + className + " extends " + baseName + " {").indent(4));
 
@@ -74,6 +86,12 @@ public class GenerateAst {
             writer.print(("final " + field + ";").indent(8));
         }
 
+        // fields filled in after construction, e.g. by the resolver or interpreter
+        if (mutableFields != null) {
+            for (String field : mutableFields.split(","))
+                writer.print((field.trim() + ";").indent(8));
+        }
+
         // constructor
         writer.print(("public " + className + "(" + fields + ") {").indent(8));
         for (String field : fieldList) {
@@ -0,0 +1,620 @@
+package com.aidan.tools;
+
+import com.aidan.cmel.Interpreter;
+import com.aidan.cmel.Parser;
+import com.aidan.cmel.Resolver;
+import com.aidan.cmel.Scanner;
+import com.aidan.cmel.Statement;
+
+import java.io.BufferedInputStream;
+import java.io.BufferedOutputStream;
+import java.io.DataInputStream;
+import java.io.DataOutputStream;
+import java.io.EOFException;
+import java.io.FileDescriptor;
+import java.io.FileOutputStream;
+import java.io.IOException;
+import java.io.InterruptedIOException;
+import java.io.OutputStream;
+import java.io.PrintStream;
+import java.lang.management.ManagementFactory;
+import java.nio.charset.StandardCharsets;
+import java.nio.file.Files;
+import java.nio.file.Path;
+import java.nio.file.Paths;
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.List;
+import java.util.Random;
+import java.util.concurrent.ExecutionException;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
+import java.util.concurrent.Future;
+import java.util.concurrent.TimeUnit;
+import java.util.concurrent.TimeoutException;
+import java.util.function.Predicate;
+
+// Runs generated Cmel programs of doubling size through the scanner, the
+// parser and resolver, and the interpreter, and reports every family whose
+// time or allocation grows faster than the family should, or which overflows
+// the stack or hangs. Offending programs are minimized and written to the output
+// directory. Programs run in a child JVM, which is killed and replaced when
+// one hangs, so a runaway program doesn't go on skewing later timings.
+public class PerformanceFuzzer {
+    private static final int MIN_SIZE = 64;
+    private static final int RUNS = 3;
+    // Doubling the input may multiply the cost by up to 2^0.4 more than the
+    // family's expected growth before it counts as an offender, which leaves
+    // room for timer and GC noise.
+    private static final double TOLERANCE = 0.4;
+    // Below this, timings are too noisy to fit.
+    private static final long MIN_NANOS = 2_000_000;
+    private static final long TIMEOUT_MILLIS = 10_000;
+    private static final long STACK_SIZE = 8 << 20;
+
+    enum Phase { SCAN, PARSE, RUN }
+
+    enum Status { OK, STACK_OVERFLOW, CRASH, TIMEOUT }
+
+    static final class Measurement {
+        final int size;
+        final Status status;
+        final long[] nanos = new long[Phase.values().length];
+        final long[] bytes = new long[Phase.values().length];
+        String failure;
+
+        Measurement(int size, Status status) {
+            this.size = size;
+            this.status = status;
+        }
+    }
+
+    // A family of programs whose cost should grow as n^growth; linearly unless
+    // it says otherwise.
+    enum Family {
+        NESTED_PARENS {
+            String generate(int n, Random random) {
+                return "var x = " + "(".repeat(n) + "1" + ")".repeat(n) + ";";
+            }
+        },
+        NESTED_BLOCKS {
+            String generate(int n, Random random) {
+                return "{".repeat(n) + "var x = 1;" + "}".repeat(n);
+            }
+        },
+        NESTED_UNARY {
+            String generate(int n, Random random) {
+                return "var x = " + "-".repeat(n) + "1;";
+            }
+        },
+        NESTED_INTERPOLATION {
+            String generate(int n, Random random) {
+                return "var x = " + "\"${".repeat(n) + "1" + "}\"".repeat(n) + ";";
+            }
+        },
+        LONG_STRING {
+            String generate(int n, Random random) {
+                StringBuilder text = new StringBuilder(n);
+                for (int i = 0; i < n; i++) text.append((char) ('a' + random.nextInt(26)));
+                return "var x = \"" + text + "\"; var y = x + x;";
+            }
+        },
+        LONG_SUM {
+            String generate(int n, Random random) {
+                return "var x = 1" + " + 1".repeat(n) + ";";
+            }
+        },
+        ELSE_IF_CHAIN {
+            String generate(int n, Random random) {
+                StringBuilder program = new StringBuilder("var x = " + n + "; var y = 0;\n");
+                for (int i = 0; i < n; i++)
+                    program.append(i == 0 ? "" : "else ").append("if (x == ").append(i).append(") y = ").append(i).append(";\n");
+                return program.append("else y = -1;").toString();
+            }
+        },
+        MANY_GLOBALS {
+            String generate(int n, Random random) {
+                StringBuilder program = new StringBuilder();
+                for (int i = 0; i < n; i++) program.append("var v").append(i).append(" = ").append(i).append(";\n");
+                for (int i = 0; i < n; i++) program.append("v").append(i).append(" = v").append(random.nextInt(n)).append(";\n");
+                return program.toString();
+            }
+        },
+        MANY_LOCALS {
+            String generate(int n, Random random) {
+                StringBuilder program = new StringBuilder("fun f() {\n");
+                for (int i = 0; i < n; i++) program.append("  var v").append(i).append(" = ").append(i).append(";\n");
+                for (int i = 0; i < n; i++) program.append("  v").append(i).append(" = v").append(random.nextInt(n)).append(";\n");
+                return program.append("}\nf();").toString();
+            }
+        },
+        DEEP_RECURSION {
+            String generate(int n, Random random) {
+                return "fun down(n) { if (n <= 0) return 0; return 1 + down(n - 1); }\nvar x = down(" + n + ");";
+            }
+        },
+        LONG_LOOP {
+            String generate(int n, Random random) {
+                return "var total = 0;\nfor (var i = 0; i < " + n + "; i = i + 1) total = total + i;";
+            }
+        },
+        // Each s + "x" copies the whole string, so this is quadratic by nature;
+        // anything worse is a regression.
+        STRING_BUILDING(2) {
+            String generate(int n, Random random) {
+                return "var s = \"\";\nfor (var i = 0; i < " + n + "; i = i + 1) s = s + \"x\";";
+            }
+        },
+        RANDOM {
+            String generate(int n, Random random) {
+                return new ProgramGenerator(random).program(n);
+            }
+        };
+
+        final double growth;
+
+        Family() {
+            this(1);
+        }
+
+        Family(double growth) {
+            this.growth = growth;
+        }
+
+        abstract String generate(int n, Random random);
+    }
+
+    // Random well-formed programs whose loops are all bounded, so every one
+    // terminates. Variables only ever hold numbers, so none stops early on a
+    // runtime error.
+    static final class ProgramGenerator {
+        private final Random random;
+        private final List<String> variables = new ArrayList<>();
+        private int budget;
+        private int depth;
+        private int loops;
+        private int fresh;
+
+        ProgramGenerator(Random random) {
+            this.random = random;
+        }
+
+        String program(int size) {
+            budget = size;
+            StringBuilder program = new StringBuilder();
+            while (budget > 0) program.append(statement()).append('\n');
+            return program.toString();
+        }
+
+        private String statement() {
+            budget--;
+            if (variables.isEmpty() || depth > 8) return declaration();
+
+            depth++;
+            String statement = switch (random.nextInt(7)) {
+                case 0 -> declaration();
+                case 1 -> pick() + " = " + expression(3) + ";";
+                case 2 -> "if (" + condition() + ") " + block() + (random.nextBoolean() ? " else " + block() : "");
+                // Nesting at most two loops keeps every program quick to run.
+                case 3 -> {
+                    if (loops == 2) yield block();
+                    String counter = "i" + fresh++;
+                    loops++;
+                    String body = block();
+                    loops--;
+                    yield "for (var " + counter + " = 0; " + counter + " < " + random.nextInt(20) + "; "
+                            + counter + " = " + counter + " + 1) " + body;
+                }
+                case 4 -> {
+                    String name = "f" + fresh++;
+                    String body = block();
+                    yield "fun " + name + "(a) " + body.substring(0, body.length() - 1) + " return a; }\n"
+                            + pick() + " = " + name + "(" + expression(2) + ");";
+                }
+                case 5 -> block();
+                default -> "var s" + fresh++ + " = \"${" + expression(2) + "}\";";
+            };
+            depth--;
+            return statement;
+        }
+
+        private String declaration() {
+            String initializer = expression(3);
+            return "var " + fresh() + " = " + initializer + ";";
+        }
+
+        private String block() {
+            // Names declared in the block go out of scope with it.
+            int visible = variables.size();
+            StringBuilder block = new StringBuilder("{ ");
+            for (int i = random.nextInt(4); i >= 0 && budget > 0; i--)
+                block.append(statement()).append(' ');
+            variables.subList(visible, variables.size()).clear();
+            return block.append('}').toString();
+        }
+
+        private String expression(int depth) {
+            if (depth == 0 || variables.isEmpty()) return atom();
+            return switch (random.nextInt(6)) {
+                case 0 -> expression(depth - 1) + " + " + expression(depth - 1);
+                case 1 -> expression(depth - 1) + " * " + expression(depth - 1);
+                case 2 -> "-" + expression(depth - 1);
+                case 3 -> "(" + expression(depth - 1) + ")";
+                case 4 -> condition() + " ? " + expression(depth - 1) + " : " + expression(depth - 1);
+                default -> atom();
+            };
+        }
+
+        private String condition() {
+            return expression(1) + (random.nextBoolean() ? " < " : " == ") + expression(1);
+        }
+
+        private String atom() {
+            if (!variables.isEmpty() && random.nextBoolean()) return pick();
+            return Integer.toString(random.nextInt(1000));
+        }
+
+        private String fresh() {
+            String name = "v" + fresh++;
+            variables.add(name);
+            return name;
+        }
+
+        private String pick() {
+            return variables.get(random.nextInt(variables.size()));
+        }
+    }
+
+    private static final PrintStream NOWHERE = new PrintStream(OutputStream.nullOutputStream());
+
+    public static void main(String[] args) throws IOException {
+        if (args.length == 1 && args[0].equals("--serve")) {
+            serve();
+            return;
+        }
+
+        int maxSize = 1 << 14;
+        long seed = System.nanoTime();
+        Path output = Paths.get("fuzz-out");
+        List<Family> families = new ArrayList<>(Arrays.asList(Family.values()));
+
+        for (int i = 0; i < args.length; i++) {
+            switch (args[i]) {
+                case "--max" -> maxSize = Integer.parseInt(args[++i]);
+                case "--seed" -> seed = Long.parseLong(args[++i]);
+                case "--out" -> output = Paths.get(args[++i]);
+                case "--family" -> families = List.of(Family.valueOf(args[++i].toUpperCase()));
+                default -> {
+                    System.err.println("Usage: performance_fuzzer [--max n] [--seed n] [--out dir] [--family name]");
+                    System.exit(64);
+                }
+            }
+        }
+
+        System.out.println("seed " + seed);
+        int offenders = 0;
+        for (Family family : families) {
+            if (!fuzz(family, maxSize, seed, output)) offenders++;
+        }
+        if (worker != null) worker.kill();
+        System.exit(offenders == 0 ? 0 : 1);
+    }
+
+    // Answers whether the family behaved.
+    private static boolean fuzz(Family family, int maxSize, long seed, Path output) throws IOException {
+        System.out.println();
+        System.out.println(family);
+        System.out.printf("%8s %12s %12s %12s %12s  %s%n", "size", "scan ms", "parse ms", "run ms", "alloc KiB", "status");
+
+        List<Measurement> measurements = new ArrayList<>();
+        for (int size = MIN_SIZE; size <= maxSize; size *= 2) {
+            String program = family.generate(size, new Random(seed));
+            Measurement measurement = measureBest(program, size);
+            measurements.add(measurement);
+            print(measurement);
+
+            if (measurement.status != Status.OK) {
+                Status status = measurement.status;
+                System.out.println("  " + status + (measurement.failure == null ? "" : ": " + measurement.failure));
+                String smallest = minimize(family, seed, size, program, source -> measure(source, 0).status == status);
+                save(output, family + "-" + status, smallest);
+                return false;
+            }
+        }
+
+        boolean asExpected = true;
+        for (Phase phase : Phase.values()) {
+            double time = exponent(measurements, phase, false);
+            double memory = exponent(measurements, phase, true);
+            if (time > family.growth + TOLERANCE || memory > family.growth + TOLERANCE) {
+                System.out.printf("  %s grows faster than n^%.0f: time ~ n^%.2f, allocation ~ n^%.2f%n", phase, family.growth, time, memory);
+                asExpected = false;
+            }
+        }
+        if (asExpected) return true;
+
+        // Keep whatever still costs at least half as much as the largest case.
+        Measurement largest = measurements.get(measurements.size() - 1);
+        String program = family.generate(largest.size, new Random(seed));
+        long budget = total(largest) / 2;
+        String smallest = minimize(family, seed, largest.size, program,
+                source -> { Measurement m = measure(source, 0); return m.status == Status.OK && total(m) >= budget; });
+        save(output, family + "-GROWTH", smallest);
+        return false;
+    }
+
+    private static long total(Measurement measurement) {
+        long total = 0;
+        for (long nanos : measurement.nanos) total += nanos;
+        return total;
+    }
+
+    // The growth exponent between the last two sizes that both took long
+    // enough to time, or 0 when there aren't two.
+    private static double exponent(List<Measurement> measurements, Phase phase, boolean memory) {
+        Measurement previous = null;
+        double exponent = 0;
+        for (Measurement measurement : measurements) {
+            if (measurement.nanos[phase.ordinal()] < MIN_NANOS) continue;
+            if (previous != null) {
+                long before = memory ? previous.bytes[phase.ordinal()] : previous.nanos[phase.ordinal()];
+                long after = memory ? measurement.bytes[phase.ordinal()] : measurement.nanos[phase.ordinal()];
+                if (before > 0 && after > 0)
+                    exponent = Math.log((double) after / before) / Math.log((double) measurement.size / previous.size);
+            }
+            previous = measurement;
+        }
+        return exponent;
+    }
+
+    private static void print(Measurement measurement) {
+        long bytes = 0;
+        for (long phase : measurement.bytes) bytes += phase;
+        System.out.printf("%8d %12.2f %12.2f %12.2f %12d  %s%n", measurement.size,
+                measurement.nanos[Phase.SCAN.ordinal()] / 1e6,
+                measurement.nanos[Phase.PARSE.ordinal()] / 1e6,
+                measurement.nanos[Phase.RUN.ordinal()] / 1e6,
+                bytes / 1024, measurement.status);
+    }
+
+    // The fastest of a few runs, after one to warm up.
+    private static Measurement measureBest(String program, int size) {
+        Measurement best = measure(program, size);
+        if (best.status != Status.OK) return best;
+        for (int i = 0; i < RUNS; i++) {
+            Measurement measurement = measure(program, size);
+            if (measurement.status != Status.OK) return measurement;
+            if (total(measurement) < total(best)) best = measurement;
+        }
+        return best;
+    }
+
+    // The child JVM measuring programs, or null before the first measurement
+    // and after one hangs.
+    private static Worker worker;
+
+    private static Measurement measure(String program, int size) {
+        try {
+            if (worker == null) worker = new Worker();
+            return worker.measure(program, size);
+        } catch (TimeoutException e) {
+            // A hung program can only be stopped with the JVM running it.
+            worker.kill();
+            worker = null;
+            return new Measurement(size, Status.TIMEOUT);
+        } catch (IOException e) {
+            if (worker != null) worker.kill();
+            worker = null;
+            Measurement failed = new Measurement(size, Status.CRASH);
+            failed.failure = "worker failed: " + e.getMessage();
+            return failed;
+        }
+    }
+
+    // A child JVM running PerformanceFuzzer --serve. It stays up between
+    // programs, so the interpreter stays warmed up as it would in process.
+    private static final class Worker {
+        private final Process process;
+        private final DataOutputStream requests;
+        private final DataInputStream responses;
+        private final ExecutorService reader = Executors.newSingleThreadExecutor(runnable -> {
+            Thread thread = new Thread(runnable, "fuzz-reader");
+            thread.setDaemon(true);
+            return thread;
+        });
+
+        Worker() throws IOException {
+            String java = ProcessHandle.current().info().command().orElse("java");
+            process = new ProcessBuilder(java, "-cp", System.getProperty("java.class.path"),
+                    PerformanceFuzzer.class.getName(), "--serve")
+                    .redirectError(ProcessBuilder.Redirect.DISCARD)
+                    .start();
+            requests = new DataOutputStream(new BufferedOutputStream(process.getOutputStream()));
+            responses = new DataInputStream(new BufferedInputStream(process.getInputStream()));
+        }
+
+        Measurement measure(String program, int size) throws IOException, TimeoutException {
+            byte[] source = program.getBytes(StandardCharsets.UTF_8);
+            requests.writeInt(size);
+            requests.writeInt(source.length);
+            requests.write(source);
+            requests.flush();
+
+            Future<Measurement> response = reader.submit(() -> readMeasurement(responses, size));
+            try {
+                return response.get(TIMEOUT_MILLIS, TimeUnit.MILLISECONDS);
+            } catch (InterruptedException e) {
+                Thread.currentThread().interrupt();
+                throw new InterruptedIOException("interrupted waiting for the worker");
+            } catch (ExecutionException e) {
+                if (e.getCause() instanceof IOException io) throw io;
+                throw new IOException(e.getCause());
+            }
+        }
+
+        void kill() {
+            process.destroyForcibly();
+            reader.shutdownNow();
+        }
+    }
+
+    // The child's side: measures each program it is sent, with the
+    // interpreter's output and error reports thrown away, until its input
+    // closes.
+    private static void serve() throws IOException {
+        DataInputStream requests = new DataInputStream(new BufferedInputStream(System.in));
+        DataOutputStream responses = new DataOutputStream(new BufferedOutputStream(new FileOutputStream(FileDescriptor.out)));
+        System.setOut(NOWHERE);
+        System.setErr(NOWHERE);
+
+        while (true) {
+            int size;
+            try {
+                size = requests.readInt();
+            } catch (EOFException e) {
+                return;
+            }
+            byte[] source = requests.readNBytes(requests.readInt());
+            writeMeasurement(responses, measureHere(new String(source, StandardCharsets.UTF_8), size));
+            responses.flush();
+        }
+    }
+
+    // Runs the program on a thread of its own, with a known stack size.
+    private static Measurement measureHere(String program, int size) {
+        Measurement[] result = new Measurement[1];
+        Thread thread = new Thread(null, () -> result[0] = phases(program, size), "fuzz", STACK_SIZE);
+        thread.start();
+        try {
+            thread.join();
+        } catch (InterruptedException e) {
+            Thread.currentThread().interrupt();
+        }
+        return result[0];
+    }
+
+    private static void writeMeasurement(DataOutputStream out, Measurement measurement) throws IOException {
+        out.writeByte(measurement.status.ordinal());
+        for (Phase phase : Phase.values()) {
+            out.writeLong(measurement.nanos[phase.ordinal()]);
+            out.writeLong(measurement.bytes[phase.ordinal()]);
+        }
+        String failure = measurement.failure == null ? "" : measurement.failure;
+        out.writeUTF(failure.length() > 1000 ? failure.substring(0, 1000) : failure);
+    }
+
+    private static Measurement readMeasurement(DataInputStream in, int size) throws IOException {
+        Measurement measurement = new Measurement(size, Status.values()[in.readByte()]);
+        for (Phase phase : Phase.values()) {
+            measurement.nanos[phase.ordinal()] = in.readLong();
+            measurement.bytes[phase.ordinal()] = in.readLong();
+        }
+        String failure = in.readUTF();
+        if (!failure.isEmpty()) measurement.failure = failure;
+        return measurement;
+    }
+
+    private static Measurement phases(String program, int size) {
+        com.sun.management.ThreadMXBean threads = (com.sun.management.ThreadMXBean) ManagementFactory.getThreadMXBean();
+        long thread = Thread.currentThread().threadId();
+        Measurement measurement = new Measurement(size, Status.OK);
+        Phase phase = Phase.SCAN;
+        try {
+            long start = System.nanoTime();
+            long allocated = threads.getThreadAllocatedBytes(thread);
+            new Scanner(program).scanTokens();
+            allocated = record(measurement, phase, start, allocated, threads, thread);
+
+            // The front end is a single pass, so this scans the program again;
+            // the scan on its own is subtracted out.
+            phase = Phase.PARSE;
+            start = System.nanoTime();
+            Interpreter interpreter = new Interpreter();
+            List<Statement> statements = new Parser(new Scanner(program), new Resolver(interpreter)).parse();
+            allocated = record(measurement, phase, start, allocated, threads, thread);
+            measurement.nanos[Phase.PARSE.ordinal()] = Math.max(0, measurement.nanos[Phase.PARSE.ordinal()] - measurement.nanos[Phase.SCAN.ordinal()]);
+            measurement.bytes[Phase.PARSE.ordinal()] = Math.max(0, measurement.bytes[Phase.PARSE.ordinal()] - measurement.bytes[Phase.SCAN.ordinal()]);
+
+            phase = Phase.RUN;
+            start = System.nanoTime();
+            interpreter.interpret(statements);
+            record(measurement, phase, start, allocated, threads, thread);
+            return measurement;
+        } catch (StackOverflowError error) {
+            Measurement failed = new Measurement(size, Status.STACK_OVERFLOW);
+            failed.failure = "in " + phase;
+            return failed;
+        } catch (Throwable error) {
+            Measurement failed = new Measurement(size, Status.CRASH);
+            failed.failure = error.toString();
+            return failed;
+        }
+    }
+
+    private static long record(Measurement measurement, Phase phase, long start, long allocatedBefore,
+                               com.sun.management.ThreadMXBean threads, long thread) {
+        measurement.nanos[phase.ordinal()] = System.nanoTime() - start;
+        long allocated = threads.getThreadAllocatedBytes(thread);
+        measurement.bytes[phase.ordinal()] = allocated - allocatedBefore;
+        return allocated;
+    }
+
+    // First finds the smallest size of the family that still offends, then
+    // removes lines, and finally characters, from that program for as long as
+    // it still does.
+    private static String minimize(Family family, long seed, int size, String program, Predicate<String> offends) {
+        int low = MIN_SIZE / 2;
+        int high = size;
+        while (high - low > 1) {
+            int middle = (low + high) >>> 1;
+            String candidate = family.generate(middle, new Random(seed));
+            if (offends.test(candidate)) {
+                high = middle;
+                program = candidate;
+            } else {
+                low = middle;
+            }
+        }
+
+        program = String.join("\n", shrink(new ArrayList<>(Arrays.asList(program.split("\n"))), "\n", offends));
+        List<String> characters = new ArrayList<>();
+        for (char c : program.toCharArray()) characters.add(String.valueOf(c));
+        // Past this many characters removing them one chunk at a time is too
+        // slow to be worth it.
+        if (characters.size() <= 4096)
+            program = String.join("", shrink(characters, "", offends));
+        return program;
+    }
+
+    // Delta debugging: tries removing each of n chunks in turn, doubling n
+    // whenever none can go.
+    private static List<String> shrink(List<String> parts, String separator, Predicate<String> offends) {
+        int chunks = 2;
+        while (parts.size() >= 2) {
+            int chunk = Math.max(1, parts.size() / chunks);
+            boolean removed = false;
+            for (int start = 0; start < parts.size(); start += chunk) {
+                List<String> candidate = new ArrayList<>(parts.subList(0, start));
+                candidate.addAll(parts.subList(Math.min(parts.size(), start + chunk), parts.size()));
+                if (!candidate.isEmpty() && offends.test(String.join(separator, candidate))) {
+                    parts = candidate;
+                    chunks = Math.max(chunks - 1, 2);
+                    removed = true;
+                    break;
+                }
+            }
+            if (!removed) {
+                if (chunk == 1) break;
+                chunks = Math.min(parts.size(), chunks * 2);
+            }
+        }
+        return parts;
+    }
+
+    private static void save(Path output, String name, String program) throws IOException {
+        Files.createDirectories(output);
+        Path file = output.resolve(name.toLowerCase() + ".cmel");
+        Files.write(file, program.getBytes(StandardCharsets.UTF_8));
+        System.out.println("  minimized to " + program.length() + " characters: " + file);
+    }
+}